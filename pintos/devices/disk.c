@@ -71,7 +71,8 @@ struct channel {
 	struct lock lock;           /* Must acquire to access the controller. */
 	bool expecting_interrupt;   /* True if an interrupt is expected, false if
 								   any interrupt would be spurious. */
-	struct semaphore completion_wait;   /* Up'd by interrupt handler. */
+	struct semaphore completion_wait;   /* Up'd by `completion'. */
+	struct tasklet completion;  /* Queued by interrupt handler. */
 
 	struct disk devices[2];     /* The devices on this channel. */
 };
@@ -95,6 +96,7 @@ static void select_device (const struct disk *);
 static void select_device_wait (const struct disk *);
 
 static void interrupt_handler (struct intr_frame *);
+static void complete_command (void *c_);
 
 /* Initialize the disk subsystem and detect disks. */
 void
@@ -119,9 +121,10 @@ disk_init (void) {
 			default:
 				NOT_REACHED ();
 		}
-		lock_init (&c->lock);
+		lock_init_named (&c->lock, c->name);
 		c->expecting_interrupt = false;
 		sema_init (&c->completion_wait, 0);
+		tasklet_init (&c->completion, complete_command, c);
 
 		/* Initialize devices. */
 		for (dev_no = 0; dev_no < 2; dev_no++) {
@@ -511,7 +514,8 @@ select_device_wait (const struct disk *d) {
 	wait_until_idle (d);
 }
 
-/* ATA interrupt handler. */
+/* ATA interrupt handler.  Only acknowledges the interrupt;
+   waking the waiter is left to the channel's tasklet. */
 static void
 interrupt_handler (struct intr_frame *f) {
 	struct channel *c;
@@ -520,7 +524,7 @@ interrupt_handler (struct intr_frame *f) {
 		if (f->vec_no == c->irq) {
 			if (c->expecting_interrupt) {
 				inb (reg_status (c));               /* Acknowledge interrupt. */
-				sema_up (&c->completion_wait);      /* Wake up waiter. */
+				tasklet_schedule (&c->completion);  /* Wake up waiter. */
 			} else
 				printf ("%s: unexpected interrupt\n", c->name);
 			return;
@@ -529,6 +533,15 @@ interrupt_handler (struct intr_frame *f) {
 	NOT_REACHED ();
 }
 
+/* Tasklet for channel C_: wakes up the thread waiting for the
+   command that just completed. */
+static void
+complete_command (void *c_) {
+	struct channel *c = c_;
+
+	sema_up (&c->completion_wait);
+}
+
 static void
 inspect_read_cnt (struct intr_frame *f) {
 	struct disk * d = disk_get (f->R.rdx, f->R.rcx);
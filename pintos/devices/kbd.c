@@ -23,11 +23,24 @@ static bool caps_lock;
 /* Number of keys pressed. */
 static int64_t key_cnt;
 
+/* Scancodes read by the interrupt handler but not yet
+   interpreted, as a ring buffer.  Interrupts must be off to
+   access it. */
+#define SCANCODE_CNT 64
+static unsigned scancodes[SCANCODE_CNT];
+static size_t scancode_head, scancode_tail;
+
+/* Interprets the buffered scancodes. */
+static struct tasklet decode_tasklet;
+
 static intr_handler_func keyboard_interrupt;
+static void decode_scancodes (void *aux);
+static void interpret_scancode (unsigned code);
 
 /* Initializes the keyboard. */
 void
 kbd_init (void) {
+	tasklet_init (&decode_tasklet, decode_scancodes, NULL);
 	intr_register_ext (0x21, keyboard_interrupt, "8042 Keyboard");
 }
 
@@ -84,26 +97,60 @@ static const struct keymap shifted_keymap[] = {
 
 static bool map_key (const struct keymap[], unsigned scancode, uint8_t *);
 
+/* Keyboard interrupt handler.  Reads the scancode, which
+   acknowledges the controller, and leaves interpreting it to
+   `decode_tasklet'.  A scancode that finds the buffer full is
+   dropped, like a key that finds the input buffer full. */
 static void
 keyboard_interrupt (struct intr_frame *args UNUSED) {
+	unsigned code;
+
+	/* Read scancode, including second byte if prefix code. */
+	code = inb (DATA_REG);
+	if (code == 0xe0)
+		code = (code << 8) | inb (DATA_REG);
+
+	if ((scancode_head + 1) % SCANCODE_CNT != scancode_tail) {
+		scancodes[scancode_head] = code;
+		scancode_head = (scancode_head + 1) % SCANCODE_CNT;
+	}
+	tasklet_schedule (&decode_tasklet);
+}
+
+/* Tasklet: interprets every buffered scancode. */
+static void
+decode_scancodes (void *aux UNUSED) {
+	for (;;) {
+		enum intr_level old_level = intr_disable ();
+		unsigned code;
+
+		if (scancode_tail == scancode_head) {
+			intr_set_level (old_level);
+			break;
+		}
+		code = scancodes[scancode_tail];
+		scancode_tail = (scancode_tail + 1) % SCANCODE_CNT;
+		interpret_scancode (code);
+		intr_set_level (old_level);
+	}
+}
+
+/* Updates the shift state or appends a character to the input
+   buffer according to CODE.  Interrupts must be off. */
+static void
+interpret_scancode (unsigned code) {
 	/* Status of shift keys. */
 	bool shift = left_shift || right_shift;
 	bool alt = left_alt || right_alt;
 	bool ctrl = left_ctrl || right_ctrl;
 
-	/* Keyboard scancode. */
-	unsigned code;
-
 	/* False if key pressed, true if key released. */
 	bool release;
 
 	/* Character that corresponds to `code'. */
 	uint8_t c;
 
-	/* Read scancode, including second byte if prefix code. */
-	code = inb (DATA_REG);
-	if (code == 0xe0)
-		code = (code << 8) | inb (DATA_REG);
+	ASSERT (intr_get_level () == INTR_OFF);
 
 	/* Bit 0x80 distinguishes key press from key release
 	   (even if there's a prefix). */
@@ -0,0 +1,178 @@
+#include "devices/lapic.h"
+#include <debug.h>
+#include <stdint.h>
+#include "intrinsic.h"
+#include "threads/init.h"
+#include "threads/mmu.h"
+#include "threads/pte.h"
+#include "threads/vaddr.h"
+
+/* See [IA32-v3a] chapter 10 "Advanced Programmable Interrupt
+   Controller (APIC)" for hardware details. */
+
+/* IA32_APIC_BASE MSR. */
+#define MSR_APIC_BASE 0x1b
+#define APIC_BASE_ENABLE (1 << 11)      /* xAPIC globally enabled. */
+#define APIC_BASE_ADDR 0xfffff000       /* Physical base of the registers. */
+
+/* IA32_TSC_DEADLINE MSR. */
+#define MSR_TSC_DEADLINE 0x6e0
+
+/* CPUID.1 feature bits. */
+#define CPUID_EDX_APIC (1 << 9)
+#define CPUID_ECX_TSC_DEADLINE (1 << 24)
+
+/* Register offsets from the base. */
+#define REG_TPR 0x080                   /* Task Priority. */
+#define REG_EOI 0x0b0                   /* End Of Interrupt. */
+#define REG_SVR 0x0f0                   /* Spurious Interrupt Vector. */
+#define REG_LVT_TIMER 0x320             /* LVT Timer. */
+#define REG_LVT_LINT0 0x350             /* LVT LINT0. */
+#define REG_LVT_LINT1 0x360             /* LVT LINT1. */
+#define REG_TIMER_INIT 0x380            /* Timer Initial Count. */
+#define REG_TIMER_CUR 0x390             /* Timer Current Count. */
+#define REG_TIMER_DIV 0x3e0             /* Timer Divide Configuration. */
+
+#define SVR_ENABLE (1 << 8)             /* APIC software enable. */
+#define LVT_MASKED (1 << 16)            /* Interrupt masked. */
+#define LVT_EXTINT (7 << 8)             /* Delivery mode ExtINT. */
+#define LVT_NMI (4 << 8)                /* Delivery mode NMI. */
+#define LVT_TIMER_DEADLINE (2 << 17)    /* Timer mode TSC-deadline. */
+#define TIMER_DIV_1 0xb                 /* Count at the bus clock rate. */
+
+/* Longest one-shot we program, in units of the calibration
+   interval.  Keeps the conversion below from overflowing; a
+   later expiry just takes one extra, early interrupt. */
+#define MAX_ARM_INTERVALS 16
+
+static volatile uint32_t *regs; /* Mapped registers, or NULL if absent. */
+static bool use_tsc_deadline;   /* Timer supports TSC-deadline mode? */
+
+/* Calibration: the timer counted LAPIC_CAL while the TSC
+   advanced by TSC_CAL cycles. */
+static uint64_t lapic_cal, tsc_cal;
+
+static uint32_t lapic_read (int reg);
+static void lapic_write (int reg, uint32_t value);
+
+/* Maps and software-enables the local APIC, if the CPU has one,
+   keeping PIC interrupts flowing through LINT0.  Must run after
+   paging_init(), and before any user page table is created so
+   that every page table shares the mapping. */
+void
+lapic_init (void) {
+	uint32_t a, b, c, d;
+	uint64_t base, va;
+	uint64_t *pte;
+
+	cpuid (1, 0, &a, &b, &c, &d);
+	if (!(d & CPUID_EDX_APIC))
+		return;
+	use_tsc_deadline = (c & CPUID_ECX_TSC_DEADLINE) != 0;
+
+	base = read_msr (MSR_APIC_BASE);
+	if (!(base & APIC_BASE_ENABLE))
+		write_msr (MSR_APIC_BASE, base | APIC_BASE_ENABLE);
+	base &= APIC_BASE_ADDR;
+
+	/* The registers lie above RAM, outside paging_init()'s map. */
+	va = (uint64_t) ptov (base);
+	pte = pml4e_walk (base_pml4, va, 1);
+	ASSERT (pte != NULL);
+	*pte = base | PTE_P | PTE_W | PTE_PCD | PTE_PWT;
+	regs = (volatile uint32_t *) va;
+
+	lapic_write (REG_SVR, SVR_ENABLE | LAPIC_SPURIOUS_VEC);
+	lapic_write (REG_LVT_LINT0, LVT_EXTINT);
+	lapic_write (REG_LVT_LINT1, LVT_NMI);
+	lapic_write (REG_LVT_TIMER, LVT_MASKED | LAPIC_TIMER_VEC);
+	lapic_write (REG_TIMER_DIV, TIMER_DIV_1);
+	lapic_write (REG_TPR, 0);
+}
+
+/* Returns true if lapic_init() found and enabled a local APIC. */
+bool
+lapic_present (void) {
+	return regs != NULL;
+}
+
+/* Acknowledges the interrupt being handled. */
+void
+lapic_eoi (void) {
+	lapic_write (REG_EOI, 0);
+}
+
+/* Starts the timer counting down from its maximum, masked, so
+   that lapic_timer_calibrate_end() can see how far it got. */
+void
+lapic_timer_calibrate_begin (void) {
+	if (regs == NULL)
+		return;
+	lapic_write (REG_LVT_TIMER, LVT_MASKED | LAPIC_TIMER_VEC);
+	lapic_write (REG_TIMER_INIT, UINT32_MAX);
+}
+
+/* Records how far the timer counted while the TSC advanced by
+   TSC_ELAPSED cycles, then stops it and unmasks its interrupt,
+   in TSC-deadline mode if the CPU supports it. */
+void
+lapic_timer_calibrate_end (uint64_t tsc_elapsed) {
+	if (regs == NULL)
+		return;
+	lapic_cal = UINT32_MAX - lapic_read (REG_TIMER_CUR);
+	tsc_cal = tsc_elapsed;
+	lapic_write (REG_TIMER_INIT, 0);
+	lapic_write (REG_LVT_TIMER,
+			LAPIC_TIMER_VEC | (use_tsc_deadline ? LVT_TIMER_DEADLINE : 0));
+}
+
+/* Returns true if the timer is armed by TSC value rather than by
+   a count derived from calibration. */
+bool
+lapic_timer_tsc_deadline (void) {
+	return use_tsc_deadline;
+}
+
+/* Arms the timer to interrupt once, when the TSC reaches
+   DEADLINE or as soon as possible if that has passed.
+   Replaces any earlier arming.  Interrupts must be off. */
+void
+lapic_timer_arm (uint64_t deadline) {
+	uint64_t now, delta, count;
+
+	ASSERT (regs != NULL);
+	if (use_tsc_deadline) {
+		write_msr (MSR_TSC_DEADLINE, deadline);
+		return;
+	}
+
+	ASSERT (tsc_cal != 0);
+	now = rdtsc ();
+	delta = deadline > now ? deadline - now : 0;
+	if (delta > tsc_cal * MAX_ARM_INTERVALS)
+		delta = tsc_cal * MAX_ARM_INTERVALS;
+	count = delta * lapic_cal / tsc_cal;
+	lapic_write (REG_TIMER_INIT, count > 0 ? count : 1);
+}
+
+/* Cancels any pending timer interrupt. */
+void
+lapic_timer_disarm (void) {
+	ASSERT (regs != NULL);
+	if (use_tsc_deadline)
+		write_msr (MSR_TSC_DEADLINE, 0);
+	else
+		lapic_write (REG_TIMER_INIT, 0);
+}
+
+/* Returns local APIC register REG. */
+static uint32_t
+lapic_read (int reg) {
+	return regs[reg / sizeof *regs];
+}
+
+/* Sets local APIC register REG to VALUE. */
+static void
+lapic_write (int reg, uint32_t value) {
+	regs[reg / sizeof *regs] = value;
+}
@@ -5,6 +5,8 @@
 #include <round.h>
 #include <stdio.h>
 
+#include "devices/lapic.h"
+#include "intrinsic.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/synch.h"
@@ -22,15 +24,60 @@
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
-/* Number of loops per timer tick.
-   Initialized by timer_calibrate(). */
-static unsigned loops_per_tick;
+/* Last tick whose timers and mlfqs bookkeeping the timer softirq
+   has run.  Trails `ticks' only while that softirq is pending. */
+static int64_t softirq_ticks;
+
+/* Hashed timing wheel.  A pending timer that expires at tick T
+   sits in slot T % TIMER_WHEEL_SLOTS, so timer_add() and
+   timer_cancel() are O(1).  Each tick only examines the one slot
+   for the current tick; entries more than one revolution away
+   stay put until their round comes up.  The slots are drained by
+   the timer softirq, not by the interrupt handler itself. */
+#define TIMER_WHEEL_SLOTS 256
+static struct list timer_wheel[TIMER_WHEEL_SLOTS];
+
+/* TSC clocksource.  timer_calibrate() measures the TSC rate
+   against the 8254 once; from then on the TSC alone tells time
+   at sub-tick resolution. */
+#define CALIBRATE_MS 5        /* Length of the calibration run. */
+static uint64_t tsc_hz;       /* TSC cycles per second. */
+static uint64_t tsc_per_tick; /* TSC cycles per timer tick. */
+static uint64_t tsc_base;     /* TSC value at which timer_ns() is 0. */
+
+/* High-resolution timers, earliest expiry on top.  With a local
+   APIC, its timer is armed in one-shot (or TSC-deadline) mode for
+   the top entry; without one, expiries are only noticed at the
+   next tick. */
+static struct heap hrtimers;
+static bool hrtimer_hw; /* Local APIC timer drives hrtimers? */
+
+/* 8254 input clock, in Hz, and counts per timer tick. */
+#define PIT_HZ 1193180
+static uint16_t pit_tick_count;
+
+/* If true, the idle thread stops the periodic tick and programs
+   the 8254 in one-shot mode for the next pending timer.
+   Controlled by kernel command-line option "-o tickless". */
+bool timer_tickless;
+
+/* Ticks covered by the armed one-shot, or 0 while the 8254 is in
+   its normal periodic mode. */
+static int64_t oneshot_ticks;
 
 static intr_handler_func timer_interrupt;
-static bool too_many_loops(unsigned loops);
-static void busy_wait(int64_t loops);
+static void timer_tick_once(void);
+static void pit_set_periodic(void);
 static void real_time_sleep(int64_t num, int32_t denom);
-static bool wake_tick_less(const struct list_elem *a, const struct list_elem *b, void *aux);
+static softirq_func timer_softirq;
+static void timer_wheel_run(int64_t now);
+static void mlfqs_tick(int64_t now);
+static void wake_sleeper(void *t_);
+static intr_handler_func hrtimer_interrupt;
+static softirq_func hrtimer_run;
+static void hrtimer_program(void);
+static uint64_t ns_to_tsc(int64_t ns);
+static bool hrtimer_less(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
@@ -38,36 +85,67 @@ static bool wake_tick_less(const struct list_elem *a, const struct list_elem *b,
 void timer_init(void) {
   /* 8254 input frequency divided by TIMER_FREQ, rounded to
      nearest. */
-  uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+  pit_tick_count = (PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ;
+  pit_set_periodic();
 
-  outb(0x43, 0x34); /* CW: counter 0, LSB then MSB, mode 2, binary. */
-  outb(0x40, count & 0xff);
-  outb(0x40, count >> 8);
+  for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) list_init(&timer_wheel[i]);
+  heap_init(&hrtimers, hrtimer_less, NULL);
 
   intr_register_ext(0x20, timer_interrupt, "8254 Timer");
+  softirq_register(SOFTIRQ_TIMER, timer_softirq);
+  softirq_register(SOFTIRQ_HRTIMER, hrtimer_run);
 }
 
-/* Calibrates loops_per_tick, used to implement brief delays. */
+/* Calibrates the TSC, and the local APIC timer if present,
+   against CALIBRATE_MS milliseconds of 8254 counter 2. */
 void timer_calibrate(void) {
-  unsigned high_bit, test_bit;
+  uint16_t count = PIT_HZ * CALIBRATE_MS / 1000;
+  uint64_t tsc_start, tsc_elapsed;
+  uint8_t port61;
 
   ASSERT(intr_get_level() == INTR_ON);
   printf("Calibrating timer...  ");
 
-  /* Approximate loops_per_tick as the largest power-of-two
-     still less than one timer tick. */
-  loops_per_tick = 1u << 10;
-  while (!too_many_loops(loops_per_tick << 1)) {
-    loops_per_tick <<= 1;
-    ASSERT(loops_per_tick != 0);
-  }
+  enum intr_level old_level = intr_disable();
+
+  /* Raise counter 2's gate with the speaker off, then count down
+     once in mode 0: OUT2, bit 5 of port 0x61, goes high at 0. */
+  port61 = inb(0x61);
+  outb(0x61, (port61 & ~0x02) | 0x01);
+  outb(0x43, 0xb0); /* CW: counter 2, LSB then MSB, mode 0, binary. */
+  outb(0x42, count & 0xff);
+  outb(0x42, count >> 8);
+  tsc_start = rdtsc();
+  lapic_timer_calibrate_begin();
+  while (!(inb(0x61) & 0x20)) barrier();
+  tsc_elapsed = rdtsc() - tsc_start;
+  lapic_timer_calibrate_end(tsc_elapsed);
+  outb(0x61, port61);
+
+  tsc_hz = tsc_elapsed * 1000 / CALIBRATE_MS;
+  tsc_per_tick = tsc_hz / TIMER_FREQ;
+  tsc_base = rdtsc();
+  hrtimer_hw = lapic_present();
+  if (hrtimer_hw) intr_register_ext(LAPIC_TIMER_VEC, hrtimer_interrupt, "LAPIC Timer");
+
+  intr_set_level(old_level);
+
+  printf("%'" PRIu64 " TSC cycles/s, %s.\n", tsc_hz,
+         !hrtimer_hw ? "no local APIC"
+         : lapic_timer_tsc_deadline() ? "TSC-deadline hrtimers" : "LAPIC one-shot hrtimers");
+}
+
+/* Returns the number of TSC cycles in one timer tick, or 0 before
+   timer_calibrate(). */
+uint64_t timer_tsc_per_tick(void) { return tsc_per_tick; }
 
-  /* Refine the next 8 bits of loops_per_tick. */
-  high_bit = loops_per_tick;
-  for (test_bit = high_bit >> 1; test_bit != high_bit >> 10; test_bit >>= 1)
-    if (!too_many_loops(high_bit | test_bit)) loops_per_tick |= test_bit;
+/* Returns the nanoseconds elapsed since timer_calibrate(),
+   according to the TSC, or 0 before it. */
+int64_t timer_ns(void) {
+  if (tsc_hz == 0) return 0;
 
-  printf("%'" PRIu64 " loops/s.\n", (uint64_t)loops_per_tick * TIMER_FREQ);
+  uint64_t cycles = rdtsc() - tsc_base;
+  return cycles / tsc_hz * 1000000000 + cycles % tsc_hz * 1000000000 / tsc_hz;
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -93,14 +171,11 @@ void timer_sleep(int64_t ticks) {
   // 현제 스레드 가져오기
   struct thread *curr = thread_current();
 
-  // wake_tick 설정
-  curr->wake_tick = start + ticks;
-
   // 인터럽트 끄기
   enum intr_level old_level = intr_disable();
 
-  // sleep_list에 추가
-  list_insert_ordered(get_sleep_list(), &curr->sleep_elem, wake_tick_less, NULL);
+  // start + ticks 에 나를 깨우도록 타이머 등록
+  timer_add(&curr->sleep_timer, start + ticks, wake_sleeper, curr);
 
   // thread_block() 호출, 재 schedule 될 때까지 대기
   thread_block();
@@ -118,73 +193,229 @@ void timer_usleep(int64_t us) { real_time_sleep(us, 1000 * 1000); }
 /* Suspends execution for approximately NS nanoseconds. */
 void timer_nsleep(int64_t ns) { real_time_sleep(ns, 1000 * 1000 * 1000); }
 
+/* Arms TIMER to call FUNC (AUX) from the timer softirq once
+   timer_ticks() reaches EXPIRY.  An EXPIRY that has already
+   passed fires on the next tick.  TIMER must not already be
+   pending, and must stay valid until it fires or is cancelled.
+
+   FUNC runs in interrupt context with interrupts off, so it must
+   not sleep; it may call thread_unblock() or re-arm TIMER.  This
+   function may itself be called from an interrupt handler. */
+void timer_add(struct timer *timer, int64_t expiry, timer_func *func, void *aux) {
+  ASSERT(timer != NULL);
+  ASSERT(func != NULL);
+
+  enum intr_level old_level = intr_disable();
+  ASSERT(!timer->pending);
+
+  timer->expiry = expiry;
+  timer->func = func;
+  timer->aux = aux;
+  timer->pending = true;
+  // 이미 처리된 tick이라면 softirq가 다음에 볼 tick으로 보낸다
+  if (expiry <= softirq_ticks) expiry = softirq_ticks + 1;
+  list_push_back(&timer_wheel[expiry % TIMER_WHEEL_SLOTS], &timer->elem);
+  intr_set_level(old_level);
+}
+
+/* Disarms TIMER.  Returns true if TIMER was pending, false if it
+   had already fired or was never armed. */
+bool timer_cancel(struct timer *timer) {
+  bool was_pending;
+
+  ASSERT(timer != NULL);
+
+  enum intr_level old_level = intr_disable();
+  was_pending = timer->pending;
+  if (was_pending) {
+    list_remove(&timer->elem);
+    timer->pending = false;
+  }
+  intr_set_level(old_level);
+  return was_pending;
+}
+
+/* Arms HRTIMER to call FUNC (AUX) once timer_ns() reaches
+   EXPIRY_NS.  An EXPIRY_NS that has already passed fires as soon
+   as possible.  The same rules as for timer_add() apply: HRTIMER
+   must not already be pending, FUNC runs in interrupt context,
+   and this function may be called from an interrupt handler.
+   Must not be called before timer_calibrate(). */
+void hrtimer_add(struct hrtimer *hrtimer, int64_t expiry_ns, timer_func *func, void *aux) {
+  ASSERT(hrtimer != NULL);
+  ASSERT(func != NULL);
+  ASSERT(tsc_hz != 0);
+
+  enum intr_level old_level = intr_disable();
+  ASSERT(!hrtimer->pending);
+
+  hrtimer->expiry = ns_to_tsc(expiry_ns);
+  hrtimer->func = func;
+  hrtimer->aux = aux;
+  hrtimer->pending = true;
+  heap_push(&hrtimers, &hrtimer->elem);
+  if (heap_top(&hrtimers) == &hrtimer->elem) hrtimer_program();  // 가장 이른 만료가 바뀌었을 때만 재설정
+  intr_set_level(old_level);
+}
+
+/* Disarms HRTIMER.  Returns true if it was pending, false if it
+   had already fired or was never armed. */
+bool hrtimer_cancel(struct hrtimer *hrtimer) {
+  bool was_pending;
+
+  ASSERT(hrtimer != NULL);
+
+  enum intr_level old_level = intr_disable();
+  was_pending = hrtimer->pending;
+  if (was_pending) {
+    heap_remove(&hrtimers, &hrtimer->elem);
+    hrtimer->pending = false;
+    // 하드웨어는 그대로 둔다: 일찍 울리면 hrtimer_run()이 다시 맞춰 놓음
+  }
+  intr_set_level(old_level);
+  return was_pending;
+}
+
+/* Called by the idle thread, with interrupts off, just before it
+   halts.  In tickless mode, replaces the periodic tick with a
+   single 8254 interrupt at the next pending timer, or as far out
+   as the 16-bit counter allows (about 5 ticks at 100 Hz). */
+void timer_idle_enter(void) {
+  int64_t max_ticks = UINT16_MAX / pit_tick_count;
+  int64_t delta;
+
+  ASSERT(intr_get_level() == INTR_OFF);
+  if (!timer_tickless || oneshot_ticks != 0) return;
+  if (softirq_ticks != ticks) return;  // 밀린 하반부가 있으면 tick을 멈추지 않는다
+
+  /* Find the first upcoming tick whose slot holds an expired timer. */
+  for (delta = 1; delta < max_ticks; delta++) {
+    struct list *slot = &timer_wheel[(ticks + delta) % TIMER_WHEEL_SLOTS];
+    struct list_elem *e;
+    bool due = false;
+
+    for (e = list_begin(slot); e != list_end(slot) && !due; e = list_next(e))
+      due = list_entry(e, struct timer, elem)->expiry <= ticks + delta;
+    if (due) break;
+  }
+  if (delta <= 1) return;  // 다음 tick에 할 일이 있으면 주기 모드 그대로
+
+  uint16_t count = delta * pit_tick_count;
+  outb(0x43, 0x30); /* CW: counter 0, LSB then MSB, mode 0, binary. */
+  outb(0x40, count & 0xff);
+  outb(0x40, count >> 8);
+  oneshot_ticks = delta;
+}
+
+/* Called at the start of every external interrupt.  If the idle
+   thread had stopped the tick, restores periodic mode and replays
+   the ticks that went by, so that `ticks', the idle statistics and
+   the mlfqs load_avg/recent_cpu accounting all catch up.  If the
+   one-shot itself fired, its final tick is left to
+   timer_interrupt(). */
+void timer_idle_exit(void) {
+  uint8_t status;
+  uint16_t remaining;
+  int64_t elapsed;
+
+  ASSERT(intr_context());
+  if (oneshot_ticks == 0) return;
+
+  /* Read-back command: latch status and count of counter 0. */
+  outb(0x43, 0xc2);
+  status = inb(0x40);
+  remaining = inb(0x40);
+  remaining |= inb(0x40) << 8;
+
+  if (status & 0x80) /* OUT high: terminal count reached. */
+    elapsed = oneshot_ticks - 1;
+  else
+    elapsed = (oneshot_ticks * pit_tick_count - remaining) / pit_tick_count;
+
+  oneshot_ticks = 0;
+  pit_set_periodic();
+  while (elapsed-- > 0) timer_tick_once();
+}
+
 /* Prints timer statistics. */
 void timer_print_stats(void) { printf("Timer: %" PRId64 " ticks\n", timer_ticks()); }
 
 /* Timer interrupt handler. */
-static void timer_interrupt(struct intr_frame *args UNUSED) {
+static void timer_interrupt(struct intr_frame *args UNUSED) { timer_tick_once(); }
+
+/* Advances the clock by one tick and does the part of the
+   per-tick work that must see the interrupted thread: scheduler
+   accounting and time slices.  The rest is left to the timer
+   softirq. */
+static void timer_tick_once(void) {
   ticks++;
   thread_tick();
 
-  // 잠든 쓰레드를 깨우자
-  while (!list_empty(get_sleep_list())) {
-    struct thread *sleep_thread = list_entry(list_front(get_sleep_list()), struct thread, sleep_elem);
-    if (sleep_thread->wake_tick > ticks)  // wake_tick이 흐른 시간보다 크다면, 아직 깨울 때가 아님
-      break;
-    //깨울 때라면
-    list_pop_front(get_sleep_list());
-    thread_unblock(sleep_thread);
-  }
-
-  /* recent_cpu 증가 */
+  /* recent_cpu 증가: 이번 tick을 쓴 쓰레드에게 바로 청구 */
   if (thread_mlfqs) {  // mlqfs일 때만
     struct thread *curr = thread_current();
     if (is_not_idle(curr)) {                               // idle이 아닐 때만
+      mlfqs_settle(curr);                                  // 밀린 감쇠를 먼저 반영하고
       curr->recent_cpu = ADD_FP_INT(curr->recent_cpu, 1);  // 현재 스레드의 recent_cpu를 1 올린다
     }
+  }
 
-    // priority 최신화
-    if (ticks % 4 == 0) {
-      // 원래 모든 쓰레드를 순회해야하지만, 어짜피 바뀐건 현재쓰레드의 recent_cpu밖에 없다.
-      mlfqs_update_priority(thread_current());
-      if (thread_current()->priority <= max_priority_mlfqs_queue()) {
-        intr_yield_on_return();  // 핸들러 내부이므로 핸들러끝나고 yield
-      }
-    }
-    /* load_avg 최신화 */
-    if (ticks % TIMER_FREQ == 0) {  // 1초 마다
-      thread_update_load_avg();
-      thread_update_all_recent_cpu();
-      thread_update_all_priority();
+  softirq_raise(SOFTIRQ_TIMER);
+  if (!hrtimer_hw) softirq_raise(SOFTIRQ_HRTIMER);  // LAPIC이 없으면 tick 단위로라도 처리
+}
+
+/* Timer softirq: catches up on every tick since it last ran,
+   firing expired timers and doing the mlfqs bookkeeping.
+   Interrupts are only off while a single slot is unlinked or a
+   single callback runs. */
+static void timer_softirq(void) {
+  for (;;) {
+    enum intr_level old_level = intr_disable();
+    int64_t now;
+
+    if (softirq_ticks == ticks) {
+      intr_set_level(old_level);
+      break;
     }
+    now = ++softirq_ticks;
+    intr_set_level(old_level);
+
+    // 만료된 타이머 처리 (잠든 쓰레드 깨우기 포함)
+    timer_wheel_run(now);
+    if (thread_mlfqs) mlfqs_tick(now);
   }
 }
 
-/* Returns true if LOOPS iterations waits for more than one timer
-   tick, otherwise false. */
-static bool too_many_loops(unsigned loops) {
-  /* Wait for a timer tick. */
-  int64_t start = ticks;
-  while (ticks == start) barrier();
+/* The mlfqs work due at tick NOW, other than charging recent_cpu,
+   which timer_tick_once() already did. */
+static void mlfqs_tick(int64_t now) {
+  enum intr_level old_level = intr_disable();
+  struct thread *curr = thread_current();
 
-  /* Run LOOPS loops. */
-  start = ticks;
-  busy_wait(loops);
+  /* load_avg 최신화 */
+  if (now % TIMER_FREQ == 0) {  // 1초 마다, 쓰레드 수와 무관하게 O(1)
+    thread_update_load_avg();
+    thread_decay_recent_cpu();  // 새 감쇠 epoch 시작, 각 쓰레드에는 나중에 반영됨
+  }
 
-  /* If the tick count changed, we iterated too long. */
-  barrier();
-  return start != ticks;
+  // priority 최신화
+  if (now % 4 == 0) {
+    // 레디큐의 쓰레드들은 큐에 들어가거나 뽑힐 때 갱신되므로 현재 쓰레드만 갱신하면 된다.
+    mlfqs_settle(curr);
+    mlfqs_update_priority(curr);
+    if (curr->priority <= thread_ready_max_priority()) {
+      intr_yield_on_return();  // 하반부 안이므로 인터럽트가 끝날 때 yield
+    }
+  }
+  intr_set_level(old_level);
 }
 
-/* Iterates through a simple loop LOOPS times, for implementing
-   brief delays.
-
-   Marked NO_INLINE because code alignment can significantly
-   affect timings, so that if this function was inlined
-   differently in different places the results would be difficult
-   to predict. */
-static void NO_INLINE busy_wait(int64_t loops) {
-  while (loops-- > 0) barrier();
+/* Programs 8254 counter 0 to interrupt TIMER_FREQ times per
+   second. */
+static void pit_set_periodic(void) {
+  outb(0x43, 0x34); /* CW: counter 0, LSB then MSB, mode 2, binary. */
+  outb(0x40, pit_tick_count & 0xff);
+  outb(0x40, pit_tick_count >> 8);
 }
 
 /* Sleep for approximately NUM/DENOM seconds. */
@@ -203,18 +434,107 @@ static void real_time_sleep(int64_t num, int32_t denom) {
        timer_sleep() because it will yield the CPU to other
        processes. */
     timer_sleep(ticks);
-  } else {
-    /* Otherwise, use a busy-wait loop for more accurate
-       sub-tick timing.  We scale the numerator and denominator
-       down by 1000 to avoid the possibility of overflow. */
-    ASSERT(denom % 1000 == 0);
-    busy_wait(loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+  } else if (num > 0) {
+    /* Otherwise, less than a tick.  DENOM divides 10**9 and
+       NUM / DENOM s is under a tick, so this cannot overflow. */
+    ASSERT(1000000000 % denom == 0);
+    int64_t expiry = timer_ns() + num * (1000000000 / denom);
+
+    if (hrtimer_hw) {
+      /* Block on a one-shot hrtimer. */
+      struct hrtimer hrtimer = {.pending = false};
+      enum intr_level old_level = intr_disable();
+      hrtimer_add(&hrtimer, expiry, wake_sleeper, thread_current());
+      thread_block();
+      intr_set_level(old_level);
+    } else {
+      /* No timer hardware fine enough: spin on the TSC. */
+      while (timer_ns() < expiry) barrier();
+    }
+  }
+}
+
+/* Fires every timer in tick NOW's wheel slot whose expiry has
+   been reached, in the order they were added.  Expired timers
+   are unlinked first so that callbacks are free to re-arm or
+   cancel timers, including ones in this slot.  Each callback
+   runs with interrupts off, but they are turned back on in
+   between. */
+static void timer_wheel_run(int64_t now) {
+  struct list *slot = &timer_wheel[now % TIMER_WHEEL_SLOTS];
+  struct list expired;
+  struct list_elem *e;
+
+  list_init(&expired);
+  enum intr_level old_level = intr_disable();
+  for (e = list_begin(slot); e != list_end(slot);) {
+    struct timer *timer = list_entry(e, struct timer, elem);
+    e = list_next(e);
+    if (timer->expiry <= now) {  // 이번 바퀴에 만료된 것만, 나머지는 다음 바퀴까지 대기
+      list_remove(&timer->elem);
+      list_push_back(&expired, &timer->elem);
+    }
+  }
+  intr_set_level(old_level);
+
+  for (;;) {
+    old_level = intr_disable();
+    if (list_empty(&expired)) {  // 그 사이 timer_cancel()로 빠졌을 수도 있다
+      intr_set_level(old_level);
+      break;
+    }
+    struct timer *timer = list_entry(list_pop_front(&expired), struct timer, elem);
+    timer->pending = false;
+    timer->func(timer->aux);
+    intr_set_level(old_level);
   }
 }
 
-static bool wake_tick_less(const struct list_elem *a, const struct list_elem *b, void *aux) {
-  struct thread *thread_a = list_entry(a, struct thread, sleep_elem);
-  struct thread *thread_b = list_entry(b, struct thread, sleep_elem);
+/* LAPIC timer interrupt handler. */
+static void hrtimer_interrupt(struct intr_frame *args UNUSED) { softirq_raise(SOFTIRQ_HRTIMER); }
+
+/* hrtimer softirq: fires every hrtimer whose expiry has been
+   reached, earliest first, then re-arms the hardware for the
+   next one.  Like timer_wheel_run(), runs each callback with
+   interrupts off. */
+static void hrtimer_run(void) {
+  for (;;) {
+    enum intr_level old_level = intr_disable();
+    struct hrtimer *hrtimer = NULL;
+
+    if (!heap_empty(&hrtimers)) hrtimer = heap_entry(heap_top(&hrtimers), struct hrtimer, elem);
+    if (hrtimer == NULL || hrtimer->expiry > rdtsc()) {
+      hrtimer_program();
+      intr_set_level(old_level);
+      break;
+    }
+    heap_pop(&hrtimers);
+    hrtimer->pending = false;
+    hrtimer->func(hrtimer->aux);
+    intr_set_level(old_level);
+  }
+}
+
+/* Points the local APIC timer at the earliest pending hrtimer,
+   or stops it if there is none.  Interrupts must be off. */
+static void hrtimer_program(void) {
+  if (!hrtimer_hw) return;
+  if (heap_empty(&hrtimers))
+    lapic_timer_disarm();
+  else
+    lapic_timer_arm(heap_entry(heap_top(&hrtimers), struct hrtimer, elem)->expiry);
+}
+
+/* Converts NS, in the timer_ns() timebase, to a TSC value. */
+static uint64_t ns_to_tsc(int64_t ns) {
+  if (ns < 0) ns = 0;
+  return tsc_base + ns / 1000000000 * tsc_hz + ns % 1000000000 * tsc_hz / 1000000000;
+}
+
+/* hrtimers 힙 비교 함수: 만료가 이른 타이머가 위로 */
+static bool hrtimer_less(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED) {
+  return heap_entry(a, struct hrtimer, elem)->expiry > heap_entry(b, struct hrtimer, elem)->expiry;
+}
 
-  return thread_a->wake_tick < thread_b->wake_tick;
-}
\ No newline at end of file
+/* Timer callback for timer_sleep(): wakes up thread T_. */
+static void wake_sleeper(void *t_) { thread_unblock(t_); }
\ No newline at end of file
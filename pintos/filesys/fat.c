@@ -3,6 +3,7 @@
 #include "filesys/filesys.h"
 #include "threads/malloc.h"
 #include "threads/synch.h"
+#include "threads/vmalloc.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -53,7 +54,8 @@ fat_init (void) {
 
 void
 fat_open (void) {
-	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
+	fat_fs->fat = vmalloc (fat_fs->fat_length * sizeof (cluster_t),
+			PAL_ZERO | PAL_TAG (MEM_FILESYS));
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT load failed");
 
@@ -120,7 +122,8 @@ fat_create (void) {
 	fat_fs_init ();
 
 	// Create FAT table
-	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
+	fat_fs->fat = vmalloc (fat_fs->fat_length * sizeof (cluster_t),
+			PAL_ZERO | PAL_TAG (MEM_FILESYS));
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT creation failed");
 
@@ -4,6 +4,7 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "threads/malloc.h"
 
 static struct file *free_map_file;   /* Free map file. */
 static struct bitmap *free_map;      /* Free map, one bit per disk sector. */
@@ -11,7 +12,13 @@ static struct bitmap *free_map;      /* Free map, one bit per disk sector. */
 /* Initializes the free map. */
 void
 free_map_init (void) {
-	free_map = bitmap_create (disk_size (filesys_disk));
+	size_t bit_cnt = disk_size (filesys_disk);
+	size_t buf_size = bitmap_buf_size (bit_cnt);
+	void *buf = malloc_tagged (buf_size, MEM_FILESYS);
+
+	if (buf == NULL)
+		PANIC ("bitmap creation failed--disk is too large");
+	free_map = bitmap_create_in_buf (bit_cnt, buf, buf_size);
 	if (free_map == NULL)
 		PANIC ("bitmap creation failed--disk is too large");
 	bitmap_mark (free_map, FREE_MAP_SECTOR);
@@ -6,6 +6,7 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -53,10 +54,15 @@ byte_to_sector (const struct inode *inode, off_t pos) {
  * returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Cache of `struct inode's. */
+static struct kmem_cache *inode_cache;
+
 /* Initializes the inode module. */
 void
 inode_init (void) {
 	list_init (&open_inodes);
+	inode_cache = kmem_cache_create ("inode", sizeof (struct inode), NULL,
+			MEM_FILESYS);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -75,7 +81,7 @@ inode_create (disk_sector_t sector, off_t length) {
 	 * one sector in size, and you should fix that. */
 	ASSERT (sizeof *disk_inode == DISK_SECTOR_SIZE);
 
-	disk_inode = calloc (1, sizeof *disk_inode);
+	disk_inode = calloc_tagged (1, sizeof *disk_inode, MEM_FILESYS);
 	if (disk_inode != NULL) {
 		size_t sectors = bytes_to_sectors (length);
 		disk_inode->length = length;
@@ -115,7 +121,7 @@ inode_open (disk_sector_t sector) {
 	}
 
 	/* Allocate memory. */
-	inode = malloc (sizeof *inode);
+	inode = kmem_cache_alloc (inode_cache);
 	if (inode == NULL)
 		return NULL;
 
@@ -164,7 +170,7 @@ inode_close (struct inode *inode) {
 					bytes_to_sectors (inode->data.length)); 
 		}
 
-		free (inode); 
+		kmem_cache_free (inode_cache, inode);
 	}
 }
 
@@ -207,7 +213,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 			/* Read sector into bounce buffer, then partially copy
 			 * into caller's buffer. */
 			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
+				bounce = malloc_tagged (DISK_SECTOR_SIZE, MEM_FILESYS);
 				if (bounce == NULL)
 					break;
 			}
@@ -261,7 +267,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		} else {
 			/* We need a bounce buffer. */
 			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
+				bounce = malloc_tagged (DISK_SECTOR_SIZE, MEM_FILESYS);
 				if (bounce == NULL)
 					break;
 			}
@@ -0,0 +1,27 @@
+#ifndef DEVICES_LAPIC_H
+#define DEVICES_LAPIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Local APIC of the bootstrap processor.
+
+   Only its timer is used; device interrupts still come from the
+   8259A PICs, passed through the local APIC's LINT0 pin in
+   "virtual wire" mode.  Vectors 0x30...0x3f are reserved for
+   interrupts raised by the local APIC itself, which
+   threads/interrupt.c treats as external interrupts. */
+#define LAPIC_TIMER_VEC 0x30    /* Timer interrupt. */
+#define LAPIC_SPURIOUS_VEC 0x3f /* Spurious interrupt, never acknowledged. */
+
+void lapic_init (void);
+bool lapic_present (void);
+void lapic_eoi (void);
+
+void lapic_timer_calibrate_begin (void);
+void lapic_timer_calibrate_end (uint64_t tsc_elapsed);
+bool lapic_timer_tsc_deadline (void);
+void lapic_timer_arm (uint64_t deadline);
+void lapic_timer_disarm (void);
+
+#endif /* devices/lapic.h */
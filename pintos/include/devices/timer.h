@@ -1,14 +1,44 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <heap.h>
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* Deferred callback run from the timer softirq. */
+typedef void timer_func (void *aux);
+
+/* A kernel timer.  Embed one in the structure that owns it. */
+struct timer {
+	int64_t expiry;             /* Tick at which FUNC fires. */
+	timer_func *func;           /* Callback. */
+	void *aux;                  /* Argument to FUNC. */
+	bool pending;               /* Armed and not yet fired? */
+	struct list_elem elem;      /* Timer wheel slot element. */
+};
+
+/* A high-resolution timer, driven by the TSC and the local APIC
+   timer instead of the periodic tick. */
+struct hrtimer {
+	uint64_t expiry;            /* TSC value at which FUNC fires. */
+	timer_func *func;           /* Callback. */
+	void *aux;                  /* Argument to FUNC. */
+	bool pending;               /* Armed and not yet fired? */
+	struct heap_elem elem;      /* hrtimer heap element. */
+};
+
+/* Stop the periodic tick while idle?  Set by "-o tickless". */
+extern bool timer_tickless;
+
 void timer_init (void);
 void timer_calibrate (void);
+uint64_t timer_tsc_per_tick (void);
+int64_t timer_ns (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
@@ -18,6 +48,15 @@ void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
 
+void timer_add (struct timer *, int64_t expiry, timer_func *, void *aux);
+bool timer_cancel (struct timer *);
+
+void hrtimer_add (struct hrtimer *, int64_t expiry_ns, timer_func *, void *aux);
+bool hrtimer_cancel (struct hrtimer *);
+
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
 void timer_print_stats (void);
 
 #endif /* devices/timer.h */
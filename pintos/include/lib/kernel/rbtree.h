@@ -0,0 +1,66 @@
+#ifndef __LIB_KERNEL_RBTREE_H
+#define __LIB_KERNEL_RBTREE_H
+
+/* Red-black tree.
+ *
+ * Like the list, hash table and heap, this tree is intrusive: it
+ * never allocates memory.  Each structure that can be in a tree
+ * embeds a struct rb_node, and rb_entry() converts back from the
+ * node to the enclosing structure.
+ *
+ * The tree is ordered by a caller-supplied LESS function.
+ * Elements that compare equal are kept in insertion order, so
+ * rbtree_first() returns the least element that was inserted
+ * earliest.  rbtree_first() takes O(1) time because the leftmost
+ * node is cached; rbtree_insert() and rbtree_remove() take
+ * O(log n) time.  An element's key must not change while it is
+ * in a tree.  To change it, remove the element, update the key,
+ * and insert it again. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Tree node. */
+struct rb_node {
+	struct rb_node *parent;     /* Parent, or NULL for the root. */
+	struct rb_node *left;       /* Left child, or NULL. */
+	struct rb_node *right;      /* Right child, or NULL. */
+	bool red;                   /* Red or black? */
+};
+
+/* Converts pointer to tree node RB_NODE into a pointer to the
+   structure that RB_NODE is embedded inside.  Supply the name of
+   the outer structure STRUCT and the member name MEMBER of the
+   tree node. */
+#define rb_entry(RB_NODE, STRUCT, MEMBER)                       \
+	((STRUCT *) ((uint8_t *) &(RB_NODE)->parent             \
+		- offsetof (STRUCT, MEMBER.parent)))
+
+/* Compares the value of two tree nodes A and B, given auxiliary
+   data AUX.  Returns true if A is less than B, or false if A is
+   greater than or equal to B. */
+typedef bool rb_less_func (const struct rb_node *a,
+                           const struct rb_node *b,
+                           void *aux);
+
+/* Red-black tree. */
+struct rbtree {
+	struct rb_node *root;       /* Root, or NULL if empty. */
+	struct rb_node *leftmost;   /* Least element, or NULL. */
+	size_t size;                /* Number of elements. */
+	rb_less_func *less;         /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void rbtree_init (struct rbtree *, rb_less_func *, void *aux);
+
+void rbtree_insert (struct rbtree *, struct rb_node *);
+void rbtree_remove (struct rbtree *, struct rb_node *);
+
+struct rb_node *rbtree_first (const struct rbtree *);
+struct rb_node *rbtree_next (const struct rb_node *);
+size_t rbtree_size (const struct rbtree *);
+bool rbtree_empty (const struct rbtree *);
+
+#endif /* lib/kernel/rbtree.h */
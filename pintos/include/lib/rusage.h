@@ -0,0 +1,18 @@
+#ifndef __LIB_RUSAGE_H
+#define __LIB_RUSAGE_H
+
+#include <stdint.h>
+
+/* Shared by the kernel and user programs: the result of the
+   getrusage() system call.  Times are in TSC cycles. */
+struct rusage {
+	uint64_t ru_user_cycles;    /* Running user code. */
+	uint64_t ru_sys_cycles;     /* In the kernel: system calls and faults. */
+	uint64_t ru_irq_cycles;     /* Handling external interrupts. */
+};
+
+/* Values for getrusage()'s WHO argument. */
+#define RUSAGE_SELF 0           /* The calling process. */
+#define RUSAGE_CHILDREN (-1)    /* Its children that were waited for. */
+
+#endif /* lib/rusage.h */
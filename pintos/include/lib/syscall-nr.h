@@ -36,6 +36,9 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extras. */
+	SYS_GETRUSAGE,              /* Report CPU cycles used. */
 };
 
 #endif /* lib/syscall-nr.h */
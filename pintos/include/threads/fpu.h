@@ -0,0 +1,21 @@
+#ifndef THREADS_FPU_H
+#define THREADS_FPU_H
+
+#include <stdbool.h>
+
+struct thread;
+
+/* Lazy x87/SSE/AVX context switching.
+
+   A thread gets an XSAVE (or, on CPUs without XSAVE, FXSAVE)
+   area only once it executes its first FPU instruction.  The
+   register file is saved and reloaded only when a thread other
+   than the one whose state is currently loaded traps with #NM. */
+
+void fpu_init (void);
+void fpu_switch (struct thread *next);
+bool fpu_handle_trap (void);
+bool fpu_fork (struct thread *parent);
+void fpu_release (struct thread *);
+
+#endif /* threads/fpu.h */
@@ -1,6 +1,7 @@
 #ifndef THREADS_INTERRUPT_H
 #define THREADS_INTERRUPT_H
 
+#include <list.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -87,6 +88,36 @@ void intr_register_int (uint8_t vec, int dpl, enum intr_level,
 bool intr_context (void);
 void intr_yield_on_return (void);
 
+/* Softirqs: bottom halves of external interrupt handlers, run
+   with interrupts on just before the interrupt returns.  Lower
+   numbers run first. */
+enum softirq {
+	SOFTIRQ_TIMER,        /* Timer wheel and mlfqs bookkeeping. */
+	SOFTIRQ_HRTIMER,      /* High-resolution timers. */
+	SOFTIRQ_TASKLET,      /* Device tasklets. */
+	SOFTIRQ_CNT
+};
+
+typedef void softirq_func (void);
+
+void softirq_register (enum softirq, softirq_func *);
+void softirq_raise (enum softirq);
+
+/* A one-off piece of deferred work, queued by a device's
+   interrupt handler and run from SOFTIRQ_TASKLET.  Embed one in
+   the structure that owns it. */
+typedef void tasklet_func (void *aux);
+
+struct tasklet {
+	tasklet_func *func;         /* Callback. */
+	void *aux;                  /* Argument to FUNC. */
+	bool scheduled;             /* Queued and not yet run? */
+	struct list_elem elem;      /* Tasklet queue element. */
+};
+
+void tasklet_init (struct tasklet *, tasklet_func *, void *aux);
+void tasklet_schedule (struct tasklet *);
+
 void intr_dump_frame (const struct intr_frame *);
 const char *intr_name (uint8_t vec);
 
@@ -0,0 +1,34 @@
+#ifndef THREADS_MEMTAG_H
+#define THREADS_MEMTAG_H
+
+#include <stddef.h>
+
+/* Kernel memory accounting.
+
+   Every allocation from malloc(), a slab cache or the page
+   allocator is charged to a tag that names the subsystem it
+   belongs to.  For each tag we keep the bytes in live objects
+   and the pages held, with their peaks.  Pages that hold objects
+   of several tags, that is, malloc() arenas, are charged to
+   MEM_MALLOC; a slab's pages are charged to its cache's tag. */
+
+/* Accounting tags. */
+enum mem_tag {
+	MEM_OTHER,                  /* Untagged allocations. */
+	MEM_MALLOC,                 /* Pages of malloc() arenas. */
+	MEM_THREAD,                 /* Thread structures and stacks. */
+	MEM_PROCESS,                /* Process bookkeeping and user pages. */
+	MEM_SYSCALL,                /* System call buffers. */
+	MEM_VM,                     /* Virtual memory. */
+	MEM_FILESYS,                /* File system. */
+	MEM_TAG_CNT                 /* Number of tags. */
+};
+
+void mem_charge (enum mem_tag, size_t bytes, size_t pages);
+void mem_uncharge (enum mem_tag, size_t bytes, size_t pages);
+const char *mem_tag_name (enum mem_tag);
+void mem_print_stats (void);
+void mem_print_leaks (void);
+void register_mem_inspect_intr (void);
+
+#endif /* threads/memtag.h */
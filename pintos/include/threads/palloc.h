@@ -1,8 +1,10 @@
 #ifndef THREADS_PALLOC_H
 #define THREADS_PALLOC_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include "threads/memtag.h"
 
 /* How to allocate pages. */
 enum palloc_flags {
@@ -11,6 +13,11 @@ enum palloc_flags {
 	PAL_USER = 004              /* User page. */
 };
 
+/* Flag that charges the pages to TAG, an enum mem_tag.  Without
+   it, pages are charged to MEM_OTHER. */
+#define PAL_TAG_SHIFT 8
+#define PAL_TAG(TAG) ((enum palloc_flags) ((TAG) << PAL_TAG_SHIFT))
+
 /* Maximum number of pages to put in user pool. */
 extern size_t user_page_limit;
 
@@ -19,5 +26,9 @@ void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+void *palloc_get_huge_page (enum palloc_flags);
+bool palloc_huge_available (enum palloc_flags);
+void palloc_zero_init (void);
+void palloc_print_stats (void);
 
 #endif /* threads/palloc.h */
@@ -0,0 +1,32 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stddef.h>
+#include "threads/memtag.h"
+
+/* Object caches.
+
+   A kmem_cache hands out objects of one fixed size, packed into
+   pages obtained from the page allocator with no per-object
+   header and no rounding to a power of 2.  Caches suit kernel
+   structures that are allocated and freed often, such as struct
+   page or struct inode.
+
+   If a cache has a constructor, it runs once on each object when
+   the object's page is added to the cache, not on every
+   allocation.  An object must therefore be returned to
+   kmem_cache_free() in its constructed state. */
+
+struct kmem_cache;
+
+/* Constructor run on each new object. */
+typedef void kmem_ctor (void *obj);
+
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+		kmem_ctor *, enum mem_tag);
+void *kmem_cache_alloc (struct kmem_cache *);
+void *kmem_cache_zalloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+void kmem_print_stats (void);
+
+#endif /* threads/slab.h */
@@ -0,0 +1,27 @@
+#ifndef THREADS_SWITCH_H
+#define THREADS_SWITCH_H
+
+#include <stdint.h>
+
+/* Stack frame left by switch_threads() on a switched-out
+   thread's kernel stack, lowest address first.  thread_create()
+   builds one by hand for a new thread, with RIP pointing at
+   switch_entry and the entry arguments in R12, R13 and R14. */
+struct switch_threads_frame {
+	uint64_t r15;
+	uint64_t r14;               /* New thread: kernel_thread(). */
+	uint64_t r13;               /* New thread: AUX. */
+	uint64_t r12;               /* New thread: FUNCTION. */
+	uint64_t rbx;
+	uint64_t rbp;
+	void (*rip) (void);         /* Return address. */
+};
+
+/* Switches from the running thread, saving its stack pointer in
+   *CUR_RSP, to the thread whose saved stack pointer is NEXT_RSP. */
+void switch_threads (uint64_t *cur_rsp, uint64_t next_rsp);
+
+/* First code run by a new thread. */
+void switch_entry (void);
+
+#endif /* threads/switch.h */
@@ -1,13 +1,16 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* Current value. */
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiting threads, highest priority on top. */
+	int64_t epoch;              /* mlfqs decay epoch WAITERS are settled to. */
 };
 
 void sema_init (struct semaphore *, unsigned value);
@@ -16,22 +19,43 @@ bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
 
+/* Contention statistics of a named lock.  Times are in TSC
+   cycles.  Updated only by the lock's holder, so the lock itself
+   protects them. */
+struct lock_stats {
+	uint64_t acquired;          /* Successful acquisitions. */
+	uint64_t contended;         /* Acquisitions that had to wait. */
+	uint64_t wait_total;        /* Total time spent waiting. */
+	uint64_t wait_max;          /* Longest single wait. */
+	uint64_t hold_max;          /* Longest single hold. */
+	uint64_t acquired_at;       /* TSC at the current acquisition. */
+};
+
 /* Lock. */
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
-	struct list_elem holder_elem; /* thread의 acquired_locks의 노드 */
+	struct heap donors;         /* 이 락을 기다리는 쓰레드들 (우선순위 최대 힙) */
+	int max_priority;           /* donors 중 최대 우선순위, 없으면 PRI_MIN - 1 */
+	struct heap_elem holder_elem; /* holder의 held_locks 힙 노드 */
+	const char *name;           /* Name if profiled, otherwise NULL. */
+	struct lock_stats stats;    /* Contention statistics, if named. */
+	struct list_elem stats_elem; /* Element in the list of named locks. */
 };
 
 void lock_init (struct lock *);
+void lock_init_named (struct lock *, const char *name);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
+void lock_print_stats (void);
+void register_lock_inspect_intr (void);
 
 /* Condition variable. */
 struct condition {
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiting semaphore_elems, highest priority on top. */
+	int64_t epoch;              /* mlfqs decay epoch WAITERS are settled to. */
 };
 
 void cond_init (struct condition *);
@@ -39,6 +63,42 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Reader-writer lock with writer preference.  Any number of
+   readers may hold it at once, or a single writer.  Once a writer
+   is waiting, new readers wait too.  The active writer holds
+   WRITE_LOCK, so waiting readers and writers donate priority to
+   it. */
+struct rwlock {
+	struct lock write_lock;     /* Held by the writer, while draining or writing. */
+	unsigned readers;           /* Number of active readers. */
+	unsigned waiting_readers;   /* Readers blocked on READ_SEMA. */
+	unsigned waiting_writers;   /* Writers blocked on WRITE_LOCK. */
+	struct semaphore read_sema; /* Readers wait here. */
+	struct semaphore drain_sema; /* Writer waits here for readers to leave. */
+	bool draining;              /* A writer is waiting on DRAIN_SEMA. */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+bool rwlock_try_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+bool rwlock_try_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
+
+/* Spinlock.  Busy-waits instead of sleeping, so it may be used
+   where blocking is impossible, such as inside the scheduler.
+   Must be held with interrupts off and only for short critical
+   sections. */
+struct spinlock {
+	volatile unsigned locked;   /* Nonzero while held. */
+};
+
+void spinlock_init (struct spinlock *);
+void spinlock_acquire (struct spinlock *);
+void spinlock_release (struct spinlock *);
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
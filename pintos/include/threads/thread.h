@@ -3,8 +3,10 @@
 
 #include <debug.h>
 #include <list.h>
+#include <rbtree.h>
 #include <stdint.h>
 
+#include "devices/timer.h"
 #include "threads/fixed-point.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
@@ -31,6 +33,17 @@ typedef int tid_t;
 #define PRI_DEFAULT 31 /* Default priority. */
 #define PRI_MAX 63     /* Highest priority. */
 
+/* Thread nice values. */
+#define NICE_MIN -20   /* Most favorable nice. */
+#define NICE_MAX 20    /* Least favorable nice. */
+
+/* Classes of CPU time for per-thread TSC cycle accounting. */
+enum thread_acct {
+  ACCT_USER, /* Running user code. */
+  ACCT_SYS,  /* In the kernel: kernel threads, system calls, faults. */
+  ACCT_IRQ,  /* Handling external interrupts. */
+  ACCT_CNT
+};
 
 /* 자식 상태 */
 struct child_status {
@@ -44,6 +57,7 @@ struct child_status {
   bool load_done;             // load 한번만
   bool load_ok;               // load완료 확인
   struct list_elem elem;      // parent->children 에 매달림, 부모의 children list 용
+  uint64_t cycles[ACCT_CNT];  // 자식(과 그 자식들)이 쓴 사이클, 종료 시 기록
 };
 
 
@@ -71,7 +85,7 @@ struct child_status {
  *           |                                 |
  *           +---------------------------------+
  *           |              magic              |
- *           |            intr_frame           |
+ *           |            switch_rsp           |
  *           |                :                |
  *           |                :                |
  *           |               name              |
@@ -117,18 +131,50 @@ struct thread {
 
   /* Shared between thread.c and synch.c. */
   struct list_elem elem;       /* List element. */
-  int64_t wake_tick;           /* 쓰레드를 깨울 시간 */
-  struct list_elem sleep_elem; /* sleep_list에서의 연결리스트 노드 */
+  struct timer sleep_timer;    /* timer_sleep()에서 쓰레드를 깨울 타이머 */
   struct list_elem all_elem;   /* all_list에서의 연결리스트 노드 */
 
   int original_priority;         /* 원래 우선순위(기부 이전) */
-  struct list acquired_locks;    /* 현재 보유(점유) 중인 락들 */
+  struct heap held_locks;        /* 보유 중인 락들, max_priority 기준 최대 힙 */
   struct lock *waiting_for_lock; /* 내가 기다리고 있는 락 */
-  int is_donated;                /* 현재 우선순위가 기부받고 있는 상황인지 */
+  struct heap_elem donor_elem;   /* waiting_for_lock의 donors 힙 노드 */
+
+  /* 세마포어/조건변수 대기 힙 (threads/synch.c) */
+  struct heap_elem wait_elem;    /* 세마포어 waiters 힙 노드 */
+  uint64_t wait_seq;             /* 같은 우선순위끼리 FIFO를 지키기 위한 도착 순번 */
+  struct heap *wait_heap;        /* 지금 들어가 있는 대기 힙, 없으면 NULL */
+  struct heap_elem *wait_node;   /* wait_heap 안에서 나를 나타내는 노드 */
 
   /* mlfqs 전용*/
   int nice;           /* CPU를 양보하는 척도 (-20~20) */
   fixed_t recent_cpu; /* 최근 CPU 사용량 (fixed-point)*/
+  int64_t decay_epoch; /* recent_cpu에 감쇠를 반영한 마지막 epoch */
+
+  int cpu; /* ready 상태일 때 들어가 있는 런큐의 CPU 번호 */
+
+  /* -o fair 전용 */
+  uint64_t vruntime;        /* nice 가중치로 환산한 누적 실행 사이클 */
+  uint64_t fair_stamp;      /* vruntime에 마지막으로 반영한 TSC 값 */
+  uint64_t fair_slice_ran;  /* 이번 슬라이스에서 실행한 사이클 */
+  struct rb_node fair_node; /* fair 런큐(vruntime 순 RB 트리) 노드 */
+
+  /* EDF 실시간 클래스 (thread_set_deadline()), dl_period가 0이면 일반 쓰레드 */
+  int64_t dl_period;         /* 주기 (틱) */
+  int64_t dl_runtime;        /* 주기마다 보장받는 실행 시간 (틱) */
+  int64_t dl_deadline;       /* 현재 절대 마감 시각 (틱) */
+  int64_t dl_budget;         /* 이번 주기에 남은 실행 시간 (틱) */
+  uint64_t dl_bw;            /* dl_runtime / dl_period, 승인 제어용 고정소수점 */
+  bool dl_throttled;         /* 예산을 다 써서 다음 주기까지 멈춰 있는가? */
+  struct timer dl_timer;     /* 예산을 다시 채울 타이머 */
+  struct heap_elem dl_elem;  /* EDF 런큐(마감 시각 순 힙) 노드 */
+
+  void *fpu_area; /* FPU를 처음 쓸 때 할당되는 XSAVE 영역 (threads/fpu.c) */
+
+  /* TSC 기반 CPU 사용 시간 회계 */
+  uint64_t cycles[ACCT_CNT];       /* 모드별 누적 사이클 */
+  uint64_t child_cycles[ACCT_CNT]; /* wait()로 거둔 자식들의 누적 사이클 */
+  uint64_t acct_stamp;             /* 마지막으로 사이클을 정산한 TSC 값 */
+  enum thread_acct acct_mode;      /* 지금 사이클을 쌓고 있는 모드 */
 
   int exit_status;  /* 상태 */
   bool proc_inited;  /* init 한번만 하려고 */
@@ -154,7 +200,7 @@ struct thread {
 #endif
 
   /* Owned by thread.c. */
-  struct intr_frame tf; /* Information for switching */
+  uint64_t switch_rsp;  /* Saved stack pointer while switched out. */
   unsigned magic;       /* Detects stack overflow. */
 };
 
@@ -163,6 +209,12 @@ struct thread {
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the fair-share scheduler: threads run in order of
+   virtual runtime, weighted by nice, and priorities only order
+   waiters on locks, semaphores and condition variables.
+   Controlled by kernel command-line option "-o fair". */
+extern bool thread_fair;
+
 void thread_init(void);
 void thread_start(void);
 
@@ -179,6 +231,11 @@ struct thread *thread_current(void);
 tid_t thread_tid(void);
 const char *thread_name(void);
 
+/* Most CPUs the scheduler can manage.  thread_cpu() returns the
+   running CPU's index, which is always below CPU_MAX. */
+#define CPU_MAX 8
+int thread_cpu(void);
+
 void thread_exit(void) NO_RETURN;
 void thread_yield(void);
 
@@ -187,19 +244,22 @@ void thread_set_priority(int);
 
 int thread_get_nice(void);
 void thread_set_nice(int);
+bool thread_set_deadline(int64_t period, int64_t runtime);
 int thread_get_recent_cpu(void);
-void thread_update_all_recent_cpu(void);
+void thread_decay_recent_cpu(void);
 int thread_get_load_avg(void);
 void thread_update_load_avg(void);
 void do_iret(struct intr_frame *tf);
 
-struct list *get_ready_list(void);
-struct list *get_sleep_list(void);
 
-void thread_update_all_priority(void);
 void mlfqs_update_priority(struct thread *t);
+void mlfqs_settle(struct thread *t);
+int64_t thread_decay_epoch(void);
 bool thread_priority_less(const struct list_elem *, const struct list_elem *, void *);
 bool is_not_idle(struct thread *);
-int max_priority_mlfqs_queue(void);
+int thread_ready_max_priority(void);
+void thread_set_effective_priority(struct thread *, int priority);
+int thread_effective_priority(const struct thread *);
+enum thread_acct thread_acct_switch(enum thread_acct);
 
 #endif /* threads/thread.h */
@@ -0,0 +1,39 @@
+#ifndef THREADS_VMALLOC_H
+#define THREADS_VMALLOC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "threads/loader.h"
+#include "threads/palloc.h"
+
+/* Virtually contiguous kernel allocations.
+
+   vmalloc() backs each page of an allocation with its own page
+   from the kernel pool and maps them side by side in a region of
+   kernel virtual memory set apart for the purpose.  It can
+   therefore satisfy large requests long after fragmentation has
+   made palloc_get_multiple() fail, at the cost of a page table
+   update per page.
+
+   The region lies in the same top-level page table entry as the
+   rest of the kernel, which every process's page table shares, so
+   an allocation is visible no matter which process is running.
+
+   Memory from vmalloc() is not physically contiguous, so vtop()
+   must never be applied to it. */
+
+#define VMALLOC_START (LOADER_KERN_BASE + 0x1000000000)  /* 64 GB up. */
+#define VMALLOC_SIZE  0x10000000                         /* 256 MB. */
+#define VMALLOC_END   (VMALLOC_START + VMALLOC_SIZE)
+
+/* Is VADDR inside the vmalloc() region? */
+#define is_vmalloc_addr(VADDR) \
+	((uint64_t) (VADDR) >= VMALLOC_START && (uint64_t) (VADDR) < VMALLOC_END)
+
+void vmalloc_init (void);
+void *vmalloc (size_t size, enum palloc_flags);
+void vfree (void *);
+void vmalloc_print_stats (void);
+
+#endif /* threads/vmalloc.h */
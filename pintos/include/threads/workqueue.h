@@ -0,0 +1,62 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Deferred work.
+
+   A caller on a latency-sensitive path fills in a struct work and
+   hands it to queue_work(); one of a small pool of kernel worker
+   threads runs it later.  Each workqueue has a priority: workers
+   serve the highest-priority queue with pending work first, and
+   run its items at that priority.
+
+   Items on one queue run one at a time, in the order they were
+   queued, so flush_work() and flush_workqueue() only have to
+   compare sequence numbers.  Different queues run concurrently
+   on different workers.  A worker takes up to WORKQUEUE_BATCH
+   items from a queue at once, so a burst of small items costs
+   one wakeup and one scheduling decision. */
+
+#define WORKQUEUE_BATCH 16      /* Max items run per pick of a queue. */
+
+struct work;
+typedef void work_func (struct work *);
+
+/* One deferred item.  Usually embedded in a larger structure,
+   which the function finds with a cast or offsetof.  The function
+   may free the item, or queue it again. */
+struct work {
+	work_func *func;            /* Function to run. */
+	struct workqueue *wq;       /* Queue last queued on, or NULL. */
+	uint64_t seq;               /* Position on WQ when last queued. */
+	bool pending;               /* Queued but not yet started. */
+	struct list_elem elem;      /* Element in WQ's pending list. */
+};
+
+/* A queue of work items with a common priority. */
+struct workqueue {
+	const char *name;           /* Name (for debugging purposes). */
+	int priority;               /* Priority its items run at. */
+	struct list pending;        /* Queued struct works. */
+	uint64_t queued_seq;        /* Sequence number of last item queued. */
+	uint64_t done_seq;          /* Sequence number of last item finished. */
+	bool busy;                  /* A worker is running a batch from it. */
+	struct list flushers;       /* Threads waiting in flush_*(). */
+	struct list_elem elem;      /* Element in the list of all queues. */
+};
+
+/* General-purpose queue at PRI_DEFAULT. */
+extern struct workqueue system_wq;
+
+void workqueue_init (void);
+void workqueue_create (struct workqueue *, const char *name, int priority);
+
+void work_init (struct work *, work_func *);
+bool queue_work (struct workqueue *, struct work *);
+void flush_work (struct work *);
+void flush_workqueue (struct workqueue *);
+
+#endif /* threads/workqueue.h */
@@ -51,6 +51,7 @@ struct page {
 
 	/* Your implementation */
 	struct thread *owner;
+	struct list_elem share_elem;  // frame->pages 원소
 
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union */
@@ -65,9 +66,13 @@ struct page {
 };
 
 /* The representation of "frame" */
+/* fork 직후에는 부모와 자식의 페이지가 한 프레임을 읽기 전용으로 공유한다(copy-on-write).
+ * 먼저 쓰는 쪽이 vm_handle_wp에서 자기 사본을 받아 떨어져 나간다. */
 struct frame {
 	void *kva;
-	struct page *page;
+	struct list pages;            // 이 프레임을 매핑한 페이지들 (share_elem)
+	size_t ref_cnt;               // pages의 길이, 축출 중이면 고정용 참조 하나 더
+	bool pinned;                  // 축출 중이라 다른 축출이 건드리면 안 됨
 	struct list_elem frame_elem;
 };
 
@@ -109,12 +114,14 @@ void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
 void vm_init (void);
 bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 		bool write, bool not_present);
+bool vm_handle_wp (struct page *page);
 
 #define vm_alloc_page(type, upage, writable) \
 	vm_alloc_page_with_initializer ((type), (upage), (writable), NULL, NULL)
 bool vm_alloc_page_with_initializer (enum vm_type type, void *upage,
 		bool writable, vm_initializer *init, void *aux);
 void vm_dealloc_page (struct page *page);
+void vm_release_frame (struct page *page);
 bool vm_claim_page (void *va);
 enum vm_type page_get_type (struct page *page);
 
@@ -0,0 +1,166 @@
+#include "heap.h"
+#include "../debug.h"
+
+/* Pairing heap.
+
+   Every node keeps a pointer to its leftmost child and to its
+   next sibling, forming a binary "left-child, right-sibling"
+   tree.  PREV points to the previous sibling, or to the parent
+   for a leftmost child, which lets heap_remove() unlink an
+   arbitrary node in O(1) before merging its children.
+
+   See M. L. Fredman, R. Sedgewick, D. D. Sleator, and R. E.
+   Tarjan, "The Pairing Heap: A New Form of Self-Adjusting Heap",
+   Algorithmica 1 (1986), for the analysis. */
+
+static struct heap_elem *link (struct heap *,
+		struct heap_elem *, struct heap_elem *);
+static struct heap_elem *merge_pairs (struct heap *, struct heap_elem *);
+
+/* Initializes H as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux) {
+	ASSERT (h != NULL);
+	ASSERT (less != NULL);
+
+	h->root = NULL;
+	h->size = 0;
+	h->less = less;
+	h->aux = aux;
+}
+
+/* Inserts E into H. */
+void
+heap_push (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	e->child = e->next = e->prev = NULL;
+	h->root = h->root != NULL ? link (h, h->root, e) : e;
+	h->size++;
+}
+
+/* Removes the greatest element of H and returns it.  H must not
+   be empty. */
+struct heap_elem *
+heap_pop (struct heap *h) {
+	struct heap_elem *top;
+
+	ASSERT (h != NULL);
+	ASSERT (h->root != NULL);
+
+	top = h->root;
+	h->root = merge_pairs (h, top->child);
+	h->size--;
+	return top;
+}
+
+/* Removes E, which must be in H, from H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e) {
+	struct heap_elem *sub;
+
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	if (e == h->root) {
+		heap_pop (h);
+		return;
+	}
+
+	/* Unlink E, with its subtree, from its parent or sibling. */
+	if (e->prev->child == e)
+		e->prev->child = e->next;
+	else
+		e->prev->next = e->next;
+	if (e->next != NULL)
+		e->next->prev = e->prev;
+
+	sub = merge_pairs (h, e->child);
+	if (sub != NULL)
+		h->root = link (h, h->root, sub);
+	h->size--;
+}
+
+/* Returns the greatest element of H, or NULL if H is empty. */
+struct heap_elem *
+heap_top (const struct heap *h) {
+	ASSERT (h != NULL);
+
+	return h->root;
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (const struct heap *h) {
+	ASSERT (h != NULL);
+
+	return h->size;
+}
+
+/* Returns true if H is empty, false otherwise. */
+bool
+heap_empty (const struct heap *h) {
+	ASSERT (h != NULL);
+
+	return h->root == NULL;
+}
+
+/* Joins the heaps rooted at A and B, which must both be roots
+   (no parent and no siblings), and returns the new root. */
+static struct heap_elem *
+link (struct heap *h, struct heap_elem *a, struct heap_elem *b) {
+	struct heap_elem *t;
+
+	if (h->less (a, b, h->aux)) {
+		t = a;
+		a = b;
+		b = t;
+	}
+
+	/* B becomes A's leftmost child. */
+	b->next = a->child;
+	if (b->next != NULL)
+		b->next->prev = b;
+	b->prev = a;
+	a->child = b;
+	a->next = a->prev = NULL;
+	return a;
+}
+
+/* Merges the sibling list starting at FIRST into a single heap
+   and returns its root, or NULL if FIRST is NULL.  This is the
+   standard two-pass pairing: siblings are linked in pairs from
+   left to right, then the pairs are folded from right to left. */
+static struct heap_elem *
+merge_pairs (struct heap *h, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL;
+	struct heap_elem *root = NULL;
+
+	/* First pass.  PAIRS collects the results in reverse, chained
+	   through NEXT. */
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->next;
+
+		first = b != NULL ? b->next : NULL;
+		a->next = a->prev = NULL;
+		if (b != NULL) {
+			b->next = b->prev = NULL;
+			a = link (h, a, b);
+		}
+		a->next = pairs;
+		pairs = a;
+	}
+
+	/* Second pass. */
+	while (pairs != NULL) {
+		struct heap_elem *next = pairs->next;
+
+		pairs->next = NULL;
+		root = root != NULL ? link (h, root, pairs) : pairs;
+		pairs = next;
+	}
+	return root;
+}
@@ -0,0 +1,320 @@
+#include "rbtree.h"
+#include "../debug.h"
+
+/* Red-black tree.
+
+   A binary search tree whose nodes are colored so that no red
+   node has a red child and every path from a node down to a NULL
+   leaf passes through the same number of black nodes.  Together
+   these bound the height by 2 lg (n + 1).  Insertion and deletion
+   restore the invariants with at most three rotations.
+
+   See T. H. Cormen, C. E. Leiserson, R. L. Rivest, and C. Stein,
+   "Introduction to Algorithms", 3rd ed., chapter 13, which this
+   follows closely, except that leaves are NULL pointers instead of
+   a shared sentinel. */
+
+static void rotate_left (struct rbtree *, struct rb_node *);
+static void rotate_right (struct rbtree *, struct rb_node *);
+static void transplant (struct rbtree *, struct rb_node *, struct rb_node *);
+static void insert_fixup (struct rbtree *, struct rb_node *);
+static void remove_fixup (struct rbtree *, struct rb_node *,
+		struct rb_node *);
+static bool is_red (const struct rb_node *);
+
+/* Initializes T as an empty tree ordered by LESS, given
+   auxiliary data AUX. */
+void
+rbtree_init (struct rbtree *t, rb_less_func *less, void *aux) {
+	ASSERT (t != NULL);
+	ASSERT (less != NULL);
+
+	t->root = NULL;
+	t->leftmost = NULL;
+	t->size = 0;
+	t->less = less;
+	t->aux = aux;
+}
+
+/* Inserts N into T.  N goes after every element equal to it. */
+void
+rbtree_insert (struct rbtree *t, struct rb_node *n) {
+	struct rb_node *parent = NULL;
+	struct rb_node **link = &t->root;
+	bool leftmost = true;
+
+	ASSERT (t != NULL);
+	ASSERT (n != NULL);
+
+	while (*link != NULL) {
+		parent = *link;
+		if (t->less (n, parent, t->aux))
+			link = &parent->left;
+		else {
+			link = &parent->right;
+			leftmost = false;
+		}
+	}
+
+	n->parent = parent;
+	n->left = n->right = NULL;
+	n->red = true;
+	*link = n;
+	if (leftmost)
+		t->leftmost = n;
+	t->size++;
+
+	insert_fixup (t, n);
+}
+
+/* Removes N, which must be in T, from T. */
+void
+rbtree_remove (struct rbtree *t, struct rb_node *n) {
+	struct rb_node *x, *x_parent;
+	bool removed_red;
+
+	ASSERT (t != NULL);
+	ASSERT (n != NULL);
+	ASSERT (t->size > 0);
+
+	if (t->leftmost == n)
+		t->leftmost = rbtree_next (n);
+
+	removed_red = n->red;
+	if (n->left == NULL) {
+		x = n->right;
+		x_parent = n->parent;
+		transplant (t, n, n->right);
+	} else if (n->right == NULL) {
+		x = n->left;
+		x_parent = n->parent;
+		transplant (t, n, n->left);
+	} else {
+		/* N has two children.  Its successor Y, which has no left
+		   child, takes N's place and color. */
+		struct rb_node *y = n->right;
+
+		while (y->left != NULL)
+			y = y->left;
+		removed_red = y->red;
+		x = y->right;
+		if (y->parent == n)
+			x_parent = y;
+		else {
+			x_parent = y->parent;
+			transplant (t, y, y->right);
+			y->right = n->right;
+			y->right->parent = y;
+		}
+		transplant (t, n, y);
+		y->left = n->left;
+		y->left->parent = y;
+		y->red = n->red;
+	}
+	t->size--;
+
+	if (!removed_red)
+		remove_fixup (t, x, x_parent);
+}
+
+/* Returns the least element of T, or NULL if T is empty. */
+struct rb_node *
+rbtree_first (const struct rbtree *t) {
+	ASSERT (t != NULL);
+
+	return t->leftmost;
+}
+
+/* Returns the element that follows N in its tree, or NULL if N
+   is the greatest. */
+struct rb_node *
+rbtree_next (const struct rb_node *n) {
+	ASSERT (n != NULL);
+
+	if (n->right != NULL) {
+		n = n->right;
+		while (n->left != NULL)
+			n = n->left;
+		return (struct rb_node *) n;
+	}
+	while (n->parent != NULL && n == n->parent->right)
+		n = n->parent;
+	return n->parent;
+}
+
+/* Returns the number of elements in T. */
+size_t
+rbtree_size (const struct rbtree *t) {
+	ASSERT (t != NULL);
+
+	return t->size;
+}
+
+/* Returns true if T is empty, false otherwise. */
+bool
+rbtree_empty (const struct rbtree *t) {
+	ASSERT (t != NULL);
+
+	return t->root == NULL;
+}
+
+/* Makes X's right child take X's place, with X as its left
+   child. */
+static void
+rotate_left (struct rbtree *t, struct rb_node *x) {
+	struct rb_node *y = x->right;
+
+	x->right = y->left;
+	if (y->left != NULL)
+		y->left->parent = x;
+	transplant (t, x, y);
+	y->left = x;
+	x->parent = y;
+}
+
+/* Makes X's left child take X's place, with X as its right
+   child. */
+static void
+rotate_right (struct rbtree *t, struct rb_node *x) {
+	struct rb_node *y = x->left;
+
+	x->left = y->right;
+	if (y->right != NULL)
+		y->right->parent = x;
+	transplant (t, x, y);
+	y->right = x;
+	x->parent = y;
+}
+
+/* Replaces the subtree rooted at U by the one rooted at V, which
+   may be NULL, as a child of U's parent. */
+static void
+transplant (struct rbtree *t, struct rb_node *u, struct rb_node *v) {
+	if (u->parent == NULL)
+		t->root = v;
+	else if (u == u->parent->left)
+		u->parent->left = v;
+	else
+		u->parent->right = v;
+	if (v != NULL)
+		v->parent = u->parent;
+}
+
+/* Restores the red-black invariants after red node N has been
+   inserted as a leaf. */
+static void
+insert_fixup (struct rbtree *t, struct rb_node *n) {
+	while (is_red (n->parent)) {
+		struct rb_node *p = n->parent;
+		struct rb_node *g = p->parent;    /* Exists: P is red. */
+
+		if (p == g->left) {
+			struct rb_node *u = g->right;
+
+			if (is_red (u)) {
+				p->red = u->red = false;
+				g->red = true;
+				n = g;
+				continue;
+			}
+			if (n == p->right) {
+				rotate_left (t, p);
+				n = p;
+				p = n->parent;
+			}
+			p->red = false;
+			g->red = true;
+			rotate_right (t, g);
+		} else {
+			struct rb_node *u = g->left;
+
+			if (is_red (u)) {
+				p->red = u->red = false;
+				g->red = true;
+				n = g;
+				continue;
+			}
+			if (n == p->left) {
+				rotate_right (t, p);
+				n = p;
+				p = n->parent;
+			}
+			p->red = false;
+			g->red = true;
+			rotate_left (t, g);
+		}
+	}
+	t->root->red = false;
+}
+
+/* Restores the red-black invariants after a black node was
+   unlinked.  X, possibly NULL, now carries an extra black; its
+   parent is X_PARENT. */
+static void
+remove_fixup (struct rbtree *t, struct rb_node *x, struct rb_node *x_parent) {
+	while (x != t->root && !is_red (x)) {
+		/* X's sibling W cannot be NULL: the path through X is one
+		   black short, so W's side holds at least one black. */
+		if (x == x_parent->left) {
+			struct rb_node *w = x_parent->right;
+
+			if (w->red) {
+				w->red = false;
+				x_parent->red = true;
+				rotate_left (t, x_parent);
+				w = x_parent->right;
+			}
+			if (!is_red (w->left) && !is_red (w->right)) {
+				w->red = true;
+				x = x_parent;
+				x_parent = x->parent;
+			} else {
+				if (!is_red (w->right)) {
+					w->left->red = false;
+					w->red = true;
+					rotate_right (t, w);
+					w = x_parent->right;
+				}
+				w->red = x_parent->red;
+				x_parent->red = false;
+				w->right->red = false;
+				rotate_left (t, x_parent);
+				x = t->root;
+			}
+		} else {
+			struct rb_node *w = x_parent->left;
+
+			if (w->red) {
+				w->red = false;
+				x_parent->red = true;
+				rotate_right (t, x_parent);
+				w = x_parent->left;
+			}
+			if (!is_red (w->left) && !is_red (w->right)) {
+				w->red = true;
+				x = x_parent;
+				x_parent = x->parent;
+			} else {
+				if (!is_red (w->left)) {
+					w->right->red = false;
+					w->red = true;
+					rotate_left (t, w);
+					w = x_parent->left;
+				}
+				w->red = x_parent->red;
+				x_parent->red = false;
+				w->left->red = false;
+				rotate_right (t, x_parent);
+				x = t->root;
+			}
+		}
+	}
+	if (x != NULL)
+		x->red = false;
+}
+
+/* Returns true if N is a red node.  NULL leaves are black. */
+static bool
+is_red (const struct rb_node *n) {
+	return n != NULL && n->red;
+}
@@ -180,6 +180,11 @@ inumber (int fd) {
 	return syscall1 (SYS_INUMBER, fd);
 }
 
+int
+getrusage (int who, struct rusage *usage) {
+	return syscall2 (SYS_GETRUSAGE, who, usage);
+}
+
 int
 symlink (const char* target, const char* linkpath) {
 	return syscall2 (SYS_SYMLINK, target, linkpath);
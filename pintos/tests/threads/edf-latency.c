@@ -0,0 +1,95 @@
+/* Checks the EDF scheduling class.
+
+   First checks admission control: a reservation of more than the
+   CPU can guarantee, or with a runtime longer than its period, is
+   refused.
+
+   Then the main thread reserves 2 ticks in every 10 and runs
+   JOB_CNT periodic jobs while LOAD_CNT threads at PRI_MAX spin in
+   the background.  Each job is released at the start of its
+   period, does about a tick of work, and must finish before the
+   period ends.  Without EDF the PRI_DEFAULT main thread would not
+   run at all until the load finishes, so every job would miss. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define LOAD_CNT 3
+#define JOB_CNT 50
+#define PERIOD 10               /* Ticks. */
+#define RUNTIME 2               /* Ticks. */
+
+static void load_thread (void *aux);
+
+static int64_t load_end;
+static struct semaphore load_done;
+
+void
+test_edf_latency (void)
+{
+  int64_t start, max_latency = 0;
+  int misses = 0;
+  int i;
+
+  ASSERT (!thread_mlfqs);
+
+  /* Admission control. */
+  if (thread_set_deadline (PERIOD, PERIOD + 1))
+    fail ("runtime longer than period was admitted");
+  if (thread_set_deadline (PERIOD, PERIOD))
+    fail ("100%% utilization was admitted");
+  if (!thread_set_deadline (PERIOD, RUNTIME))
+    fail ("20%% utilization was refused");
+  msg ("Admission control accepts 20%% and refuses 100%% utilization.");
+
+  msg ("Starting %d background threads...", LOAD_CNT);
+  start = timer_ticks ();
+  load_end = start + (JOB_CNT + 2) * PERIOD;
+  sema_init (&load_done, 0);
+  for (i = 0; i < LOAD_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "load %d", i);
+      thread_create (name, PRI_MAX, load_thread, NULL);
+    }
+
+  msg ("Running %d periodic jobs...", JOB_CNT);
+  for (i = 0; i < JOB_CNT; i++)
+    {
+      int64_t release = start + (i + 1) * PERIOD;
+      int64_t now;
+
+      timer_sleep (release - timer_ticks ());
+      now = timer_ticks ();
+      if (now - release > max_latency)
+        max_latency = now - release;
+
+      /* About one tick of work. */
+      while (timer_ticks () == now)
+        continue;
+
+      if (timer_ticks () >= release + PERIOD)
+        misses++;
+    }
+
+  thread_set_deadline (0, 0);
+  for (i = 0; i < LOAD_CNT; i++)
+    sema_down (&load_done);
+
+  if (misses != 0)
+    fail ("%d of %d jobs missed their deadlines (worst release latency "
+          "%lld ticks)", misses, JOB_CNT, (long long) max_latency);
+  msg ("No deadline misses.");
+}
+
+static void
+load_thread (void *aux UNUSED)
+{
+  while (timer_ticks () < load_end)
+    continue;
+  sema_up (&load_done);
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-latency) begin
+(edf-latency) Admission control accepts 20% and refuses 100% utilization.
+(edf-latency) Starting 3 background threads...
+(edf-latency) Running 50 periodic jobs...
+(edf-latency) No deadline misses.
+(edf-latency) end
+EOF
+pass;
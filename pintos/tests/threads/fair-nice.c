@@ -0,0 +1,87 @@
+/* Checks that the fair-share scheduler ("-o fair") splits the CPU
+   between busy threads in proportion to their nice weights.
+
+   Two threads, niced to 0 and 5, spin for 10 seconds counting the
+   timer ticks they observe.  Their weights are 1024 and 335, so
+   the nice-0 thread should receive 1024 / 1359, about 75%, of the
+   ticks.  The test passes if its share is within SHARE_TOLERANCE
+   percentage points of that. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 2
+#define SHARE_EXPECTED 75       /* Percent of ticks for nice 0. */
+#define SHARE_TOLERANCE 5       /* Allowed error, in percentage points. */
+
+struct thread_info
+  {
+    int64_t start_time;
+    int tick_count;
+    int nice;
+  };
+
+static void load_thread (void *aux);
+
+void
+test_fair_nice (void)
+{
+  struct thread_info info[THREAD_CNT];
+  int64_t start_time;
+  int total, share;
+  int i;
+
+  ASSERT (thread_fair);
+
+  start_time = timer_ticks ();
+  msg ("Starting %d threads with nice 0 and 5...", THREAD_CNT);
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      struct thread_info *ti = &info[i];
+      char name[16];
+
+      ti->start_time = start_time;
+      ti->tick_count = 0;
+      ti->nice = i * 5;
+
+      snprintf (name, sizeof name, "load %d", i);
+      thread_create (name, PRI_DEFAULT, load_thread, ti);
+    }
+
+  msg ("Sleeping 12 seconds to let threads run, please wait...");
+  timer_sleep (12 * TIMER_FREQ);
+
+  total = info[0].tick_count + info[1].tick_count;
+  if (total == 0)
+    fail ("load threads received no ticks");
+  share = info[0].tick_count * 100 / total;
+  if (share < SHARE_EXPECTED - SHARE_TOLERANCE
+      || share > SHARE_EXPECTED + SHARE_TOLERANCE)
+    fail ("nice 0 thread received %d%% of %d ticks, expected %d%% +/- %d",
+          share, total, SHARE_EXPECTED, SHARE_TOLERANCE);
+  msg ("CPU split within tolerance.");
+}
+
+static void
+load_thread (void *ti_)
+{
+  struct thread_info *ti = ti_;
+  int64_t sleep_time = 1 * TIMER_FREQ;
+  int64_t spin_time = sleep_time + 10 * TIMER_FREQ;
+  int64_t last_time = 0;
+
+  thread_set_nice (ti->nice);
+  timer_sleep (sleep_time - timer_elapsed (ti->start_time));
+  while (timer_elapsed (ti->start_time) < spin_time)
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        ti->tick_count++;
+      last_time = cur_time;
+    }
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fair-nice) begin
+(fair-nice) Starting 2 threads with nice 0 and 5...
+(fair-nice) Sleeping 12 seconds to let threads run, please wait...
+(fair-nice) CPU split within tolerance.
+(fair-nice) end
+EOF
+pass;
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(lock-stats) begin
+(lock-stats) 3 acquisitions, 2 contended.
+(lock-stats) Wait times recorded: yes.
+(lock-stats) Hold time recorded: yes.
+(lock-stats) After lock_try_acquire(): 4 acquisitions, 2 contended.
+(lock-stats) end
+EOF
+pass;
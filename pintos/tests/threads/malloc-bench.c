@@ -0,0 +1,99 @@
+/* Exercises the per-CPU magazines in front of malloc() and
+   reports their throughput.
+
+   The first pattern frees each block right after allocating it,
+   so it should never leave the current CPU's magazine.  The second
+   allocates BURST blocks before freeing any, which is more than a
+   magazine holds, so it goes through refills and drains of the
+   shared descriptor.  Every block is filled with a tag and checked
+   before it is freed, which catches a block handed out twice. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "devices/timer.h"
+
+/* Size of each block, about that of a struct page. */
+#define BLOCK_SIZE 96
+
+/* Blocks per burst. */
+#define BURST 256
+
+static int64_t next_tick (void);
+static void *alloc_block (int tag);
+static void free_block (void *block, int tag);
+
+void
+test_malloc_bench (void) 
+{
+  static void *blocks[BURST];
+  int64_t start, elapsed;
+  long long ops;
+  int i;
+
+  start = next_tick ();
+  ops = 0;
+  do
+    {
+      free_block (alloc_block (ops & 0xff), ops & 0xff);
+      ops++;
+    }
+  while ((elapsed = timer_elapsed (start)) < TIMER_FREQ);
+  msg ("single: %lld malloc/free pairs per second",
+       ops * TIMER_FREQ / elapsed);
+
+  start = next_tick ();
+  ops = 0;
+  do
+    {
+      for (i = 0; i < BURST; i++)
+        blocks[i] = alloc_block (i);
+      for (i = 0; i < BURST; i++)
+        free_block (blocks[i], i);
+      ops += BURST;
+    }
+  while ((elapsed = timer_elapsed (start)) < TIMER_FREQ);
+  msg ("burst of %d: %lld malloc/free pairs per second",
+       BURST, ops * TIMER_FREQ / elapsed);
+
+  pass ();
+}
+
+/* Waits for the timer to tick and returns the new tick count, so
+   that neither pattern is timed from partway through a tick. */
+static int64_t
+next_tick (void) 
+{
+  int64_t start = timer_ticks ();
+
+  while (timer_ticks () == start)
+    continue;
+  return timer_ticks ();
+}
+
+/* Allocates a block and fills it with TAG. */
+static void *
+alloc_block (int tag) 
+{
+  void *block = malloc (BLOCK_SIZE);
+
+  if (block == NULL)
+    fail ("malloc (%d) failed", BLOCK_SIZE);
+  memset (block, tag, BLOCK_SIZE);
+  return block;
+}
+
+/* Checks that BLOCK still holds TAG, then frees it. */
+static void
+free_block (void *block, int tag) 
+{
+  const unsigned char *p = block;
+  int i;
+
+  for (i = 0; i < BLOCK_SIZE; i++)
+    if (p[i] != (unsigned char) tag)
+      fail ("block %p corrupted at byte %d", block, i);
+  free (block);
+}
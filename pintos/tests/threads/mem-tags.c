@@ -0,0 +1,65 @@
+/* Allocates memory charged to one tag with malloc_tagged(),
+   realloc() and the page allocator, and checks through the memory
+   inspect interrupt that each allocation is charged to the tag
+   and that freeing gives it all back.  Nothing else uses
+   MEM_FILESYS in the threads tests. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/memtag.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Returns statistic FIELD of TAG, through int 0x46. */
+static int64_t
+mem_stat (enum mem_tag tag, int field)
+{
+  int64_t value;
+
+  asm volatile ("int $0x46" : "=a" (value) : "d" (tag), "c" (field));
+  return value;
+}
+
+static int64_t
+bytes (void)
+{
+  return mem_stat (MEM_FILESYS, 0);
+}
+
+static int64_t
+pages (void)
+{
+  return mem_stat (MEM_FILESYS, 2);
+}
+
+void
+test_mem_tags (void)
+{
+  int64_t bytes0 = bytes (), pages0 = pages ();
+  void *small, *big, *multi;
+
+  small = malloc_tagged (100, MEM_FILESYS);
+  msg ("small block: %lld bytes charged", (long long) (bytes () - bytes0));
+
+  big = malloc_tagged (3 * PGSIZE, MEM_FILESYS);
+  msg ("big block: %lld pages charged", (long long) (pages () - pages0));
+
+  multi = palloc_get_multiple (PAL_TAG (MEM_FILESYS), 2);
+  msg ("palloc: %lld pages charged", (long long) (pages () - pages0 - 4));
+
+  free (big);
+  palloc_free_multiple (multi, 2);
+  small = realloc (small, 300);
+  msg ("realloc keeps tag: %lld bytes charged",
+       (long long) (bytes () - bytes0));
+
+  free (small);
+  msg ("after free: %lld bytes, %lld pages charged",
+       (long long) (bytes () - bytes0), (long long) (pages () - pages0));
+  msg ("peak pages at least 6: %s",
+       mem_stat (MEM_FILESYS, 3) >= 6 ? "yes" : "no");
+  msg ("unknown tag: %lld", (long long) mem_stat (MEM_TAG_CNT, 0));
+}
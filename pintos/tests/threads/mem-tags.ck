@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(mem-tags) begin
+(mem-tags) small block: 128 bytes charged
+(mem-tags) big block: 4 pages charged
+(mem-tags) palloc: 2 pages charged
+(mem-tags) realloc keeps tag: 512 bytes charged
+(mem-tags) after free: 0 bytes, 0 pages charged
+(mem-tags) peak pages at least 6: yes
+(mem-tags) unknown tag: -1
+(mem-tags) end
+EOF
+pass;
@@ -0,0 +1,219 @@
+/* Stress test for reader-writer locks.
+
+   First checks the basic rules: readers share the lock, a writer
+   excludes everyone, the try variants never sleep, and readers
+   waiting on a writer donate their priority to it.
+
+   Then runs 1, 2, 4, and 8 reader threads for about a second
+   each.  Every reader yields while inside its read section, so
+   under a plain mutex only one reader could ever be inside.  The
+   test fails unless all N readers are observed inside at once,
+   and prints read throughput for each N, plus the number of
+   consistency violations seen while two writers run alongside
+   (which must be zero). */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define MAX_READERS 8
+#define WRITERS 2
+
+struct rw_shared
+  {
+    struct rwlock rw;
+    int a, b;                   /* Writers keep A == B. */
+    int active;                 /* Readers inside right now. */
+    int max_active;             /* Most readers ever inside at once. */
+    int violations;             /* Times a reader saw A != B. */
+    int64_t start;              /* Tick at which the round began. */
+    bool with_writers;          /* Writers run this round. */
+    long long reads[MAX_READERS];
+    struct semaphore done;      /* Upped by each finished thread. */
+  };
+
+struct reader_arg
+  {
+    struct rw_shared *s;
+    int id;
+  };
+
+static thread_func reader_thread;
+static thread_func writer_thread;
+static thread_func blocked_reader;
+
+static void check_rules (void);
+static long long run_round (struct rw_shared *, int readers,
+                            bool with_writers);
+
+void
+test_rwlock_stress (void) 
+{
+  static struct rw_shared s;
+  long long base = 0;
+  int n;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  check_rules ();
+
+  for (n = 1; n <= MAX_READERS; n *= 2) 
+    {
+      long long total = run_round (&s, n, false);
+
+      if (n == 1)
+        base = total;
+      if (s.max_active != n)
+        fail ("%d readers: at most %d were inside at once",
+              n, s.max_active);
+      msg ("%d readers: %lld reads/s (%lld%% of 1 reader)",
+           n, total, base > 0 ? total * 100 / base : 0);
+    }
+
+  run_round (&s, MAX_READERS, true);
+  if (s.violations != 0)
+    fail ("readers saw %d torn writes", s.violations);
+  msg ("%d readers + %d writers: %d writes, no torn reads",
+       MAX_READERS, WRITERS, s.a);
+  pass ();
+}
+
+/* Checks sharing, exclusion, the try variants, and donation. */
+static void
+check_rules (void) 
+{
+  struct rwlock rw;
+
+  rwlock_init (&rw);
+
+  rwlock_acquire_read (&rw);
+  if (!rwlock_try_acquire_read (&rw))
+    fail ("second reader could not share the lock");
+  if (rwlock_try_acquire_write (&rw))
+    fail ("writer got in while readers held the lock");
+  rwlock_release_read (&rw);
+  rwlock_release_read (&rw);
+
+  rwlock_acquire_write (&rw);
+  if (!rwlock_held_by_current_thread (&rw))
+    fail ("writer does not hold the lock");
+  if (rwlock_try_acquire_read (&rw))
+    fail ("reader got in while a writer held the lock");
+
+  thread_create ("blocked-reader", PRI_DEFAULT + 5, blocked_reader, &rw);
+  if (thread_get_priority () != PRI_DEFAULT + 5)
+    fail ("writer has priority %d, expected %d from waiting reader",
+          thread_get_priority (), PRI_DEFAULT + 5);
+  rwlock_release_write (&rw);
+  if (thread_get_priority () != PRI_DEFAULT)
+    fail ("writer kept priority %d after release",
+          thread_get_priority ());
+  msg ("sharing, exclusion and donation work");
+}
+
+/* Reads RW once; runs at higher priority than the main thread. */
+static void
+blocked_reader (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_acquire_read (rw);
+  rwlock_release_read (rw);
+}
+
+/* Runs READERS readers, and writers if WITH_WRITERS, for about a
+   second.  Returns the number of reads per second. */
+static long long
+run_round (struct rw_shared *s, int readers, bool with_writers) 
+{
+  struct reader_arg args[MAX_READERS];
+  long long total = 0;
+  int threads = readers + (with_writers ? WRITERS : 0);
+  int i;
+
+  rwlock_init (&s->rw);
+  s->a = s->b = 0;
+  s->active = s->max_active = 0;
+  s->violations = 0;
+  s->with_writers = with_writers;
+  sema_init (&s->done, 0);
+
+  /* Start on a tick boundary. */
+  s->start = timer_ticks ();
+  while (timer_elapsed (s->start) == 0)
+    continue;
+  s->start = timer_ticks ();
+
+  for (i = 0; i < readers; i++) 
+    {
+      char name[16];
+
+      args[i].s = s;
+      args[i].id = i;
+      s->reads[i] = 0;
+      snprintf (name, sizeof name, "reader %d", i);
+      thread_create (name, PRI_DEFAULT, reader_thread, &args[i]);
+    }
+  for (i = 0; with_writers && i < WRITERS; i++)
+    thread_create ("writer", PRI_DEFAULT, writer_thread, s);
+
+  for (i = 0; i < threads; i++)
+    sema_down (&s->done);
+
+  for (i = 0; i < readers; i++)
+    total += s->reads[i];
+  return total * TIMER_FREQ / timer_elapsed (s->start);
+}
+
+static void
+reader_thread (void *arg_) 
+{
+  struct reader_arg *arg = arg_;
+  struct rw_shared *s = arg->s;
+
+  while (timer_elapsed (s->start) < TIMER_FREQ) 
+    {
+      enum intr_level old_level;
+
+      rwlock_acquire_read (&s->rw);
+      old_level = intr_disable ();
+      if (++s->active > s->max_active)
+        s->max_active = s->active;
+      intr_set_level (old_level);
+
+      if (s->a != s->b)
+        s->violations++;
+      thread_yield ();
+      if (s->a != s->b)
+        s->violations++;
+
+      old_level = intr_disable ();
+      s->active--;
+      intr_set_level (old_level);
+      rwlock_release_read (&s->rw);
+      s->reads[arg->id]++;
+    }
+  sema_up (&s->done);
+}
+
+static void
+writer_thread (void *s_) 
+{
+  struct rw_shared *s = s_;
+
+  while (timer_elapsed (s->start) < TIMER_FREQ) 
+    {
+      rwlock_acquire_write (&s->rw);
+      s->a++;
+      thread_yield ();
+      s->b++;
+      rwlock_release_write (&s->rw);
+      timer_sleep (1);
+    }
+  sema_up (&s->done);
+}
@@ -0,0 +1,103 @@
+/* Checks the slab allocator.
+
+   Allocates enough objects from a cache with a constructor to
+   need several slabs, and checks that every object was
+   constructed and that no two overlap.  Then checks that a freed
+   object is handed out again without running the constructor a
+   second time, and that kmem_cache_zalloc() zeroes objects. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/slab.h"
+
+#define OBJ_CNT 200
+#define OBJ_MAGIC 0x0b1ec7ed
+
+/* An object of a size that is not a power of 2. */
+struct obj
+  {
+    unsigned magic;             /* OBJ_MAGIC once constructed. */
+    int owner;                  /* Index of allocation, or -1. */
+    char payload[33];
+  };
+
+static int constructed;
+
+static void
+obj_ctor (void *obj_)
+{
+  struct obj *obj = obj_;
+
+  obj->magic = OBJ_MAGIC;
+  obj->owner = -1;
+  constructed++;
+}
+
+void
+test_slab_cache (void)
+{
+  static struct obj *objs[OBJ_CNT];
+  struct kmem_cache *cache, *zcache;
+  struct obj *obj;
+  int before;
+  int i, j;
+
+  cache = kmem_cache_create ("slab-cache", sizeof (struct obj), obj_ctor,
+                             MEM_OTHER);
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      objs[i] = kmem_cache_alloc (cache);
+      if (objs[i] == NULL)
+        fail ("allocation %d failed", i);
+      if (objs[i]->magic != OBJ_MAGIC || objs[i]->owner != -1)
+        fail ("object %d was not constructed", i);
+      objs[i]->owner = i;
+      memset (objs[i]->payload, i, sizeof objs[i]->payload);
+    }
+  if (constructed < OBJ_CNT)
+    fail ("only %d constructor calls for %d objects", constructed, OBJ_CNT);
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      if (objs[i]->owner != i)
+        fail ("object %d overwritten by object %d", i, objs[i]->owner);
+      for (j = 0; j < (int) sizeof objs[i]->payload; j++)
+        if (objs[i]->payload[j] != (char) i)
+          fail ("object %d payload corrupted", i);
+    }
+  msg ("allocated %d distinct objects", OBJ_CNT);
+
+  /* Return an object to its constructed state and free it. */
+  obj = objs[OBJ_CNT / 2];
+  obj->owner = -1;
+  kmem_cache_free (cache, obj);
+  before = constructed;
+  objs[OBJ_CNT / 2] = kmem_cache_alloc (cache);
+  if (objs[OBJ_CNT / 2] != obj)
+    fail ("freed object was not reused");
+  if (constructed != before || obj->magic != OBJ_MAGIC || obj->owner != -1)
+    fail ("freed object was constructed again");
+  msg ("freed object reused without constructor");
+
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      objs[i]->owner = -1;
+      kmem_cache_free (cache, objs[i]);
+    }
+
+  /* Without a constructor, zalloc must clear recycled objects. */
+  zcache = kmem_cache_create ("slab-cache-zero", sizeof (struct obj), NULL,
+                              MEM_OTHER);
+  obj = kmem_cache_zalloc (zcache);
+  if (obj == NULL)
+    fail ("zalloc failed");
+  memset (obj, 0x5a, sizeof *obj);
+  kmem_cache_free (zcache, obj);
+  obj = kmem_cache_zalloc (zcache);
+  for (j = 0; j < (int) sizeof *obj; j++)
+    if (((char *) obj)[j] != 0)
+      fail ("byte %d of zalloc'd object is not zero", j);
+  kmem_cache_free (zcache, obj);
+  msg ("zalloc returns zeroed objects");
+}
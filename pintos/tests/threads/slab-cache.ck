@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(slab-cache) begin
+(slab-cache) allocated 200 distinct objects
+(slab-cache) freed object reused without constructor
+(slab-cache) zalloc returns zeroed objects
+(slab-cache) end
+EOF
+pass;
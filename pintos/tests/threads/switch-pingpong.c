@@ -0,0 +1,76 @@
+/* Times the kernel thread switch path.
+
+   Two threads at the same priority hand control back and forth
+   through a pair of semaphores for one second.  Each round trip is
+   exactly two passes through schedule() and switch_threads() with
+   nothing else runnable, so the rate tracks the cost of a switch
+   alone.  The pong thread must also see the stop flag and exit
+   through the same hand-off. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+struct pingpong
+  {
+    struct semaphore ping;      /* Upped by main, downed by pong. */
+    struct semaphore pong;      /* Upped by pong, downed by main. */
+    bool done;                  /* Set by main to stop pong. */
+  };
+
+static thread_func pong_thread;
+
+void
+test_switch_pingpong (void) 
+{
+  struct pingpong pp;
+  int64_t start, elapsed;
+  long long round_trips = 0;
+
+  sema_init (&pp.ping, 0);
+  sema_init (&pp.pong, 0);
+  pp.done = false;
+  thread_create ("pong", thread_get_priority (), pong_thread, &pp);
+
+  /* Let pong block on PING first, so the very first round trip is
+     a switch in each direction rather than a thread start. */
+  timer_sleep (1);
+
+  start = timer_ticks ();
+  do
+    {
+      sema_up (&pp.ping);
+      sema_down (&pp.pong);
+      round_trips++;
+    }
+  while ((elapsed = timer_elapsed (start)) < TIMER_FREQ);
+
+  pp.done = true;
+  sema_up (&pp.ping);
+  sema_down (&pp.pong);
+
+  if (round_trips == 0)
+    fail ("no round trip completed in %lld ticks", elapsed);
+  msg ("%lld round trips in %lld ticks", round_trips, elapsed);
+  msg ("%lld thread switches per second",
+       round_trips * 2 * TIMER_FREQ / elapsed);
+  pass ();
+}
+
+static void
+pong_thread (void *pp_) 
+{
+  struct pingpong *pp = pp_;
+
+  for (;;) 
+    {
+      sema_down (&pp->ping);
+      if (pp->done)
+        break;
+      sema_up (&pp->pong);
+    }
+  sema_up (&pp->pong);
+}
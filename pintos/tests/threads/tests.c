@@ -29,6 +29,16 @@ static const struct test tests[] =
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"switch-pingpong", test_switch_pingpong},
+    {"rwlock-stress", test_rwlock_stress},
+    {"workqueue", test_workqueue},
+    {"fair-nice", test_fair_nice},
+    {"edf-latency", test_edf_latency},
+    {"lock-stats", test_lock_stats},
+    {"malloc-bench", test_malloc_bench},
+    {"slab-cache", test_slab_cache},
+    {"mem-tags", test_mem_tags},
+    {"vmalloc", test_vmalloc},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
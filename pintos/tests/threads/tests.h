@@ -23,6 +23,16 @@ extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_condvar;
+extern test_func test_switch_pingpong;
+extern test_func test_rwlock_stress;
+extern test_func test_workqueue;
+extern test_func test_fair_nice;
+extern test_func test_edf_latency;
+extern test_func test_lock_stats;
+extern test_func test_malloc_bench;
+extern test_func test_slab_cache;
+extern test_func test_mem_tags;
+extern test_func test_vmalloc;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
 extern test_func test_mlfqs_load_avg;
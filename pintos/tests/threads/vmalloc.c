@@ -0,0 +1,67 @@
+/* Allocates a table too big for a run of physical pages to be
+   likely, checks that it is zeroed, mapped and writable page by
+   page, that a second area keeps clear of the first one's guard
+   page, and that vfree() returns every page and lets the space be
+   reused. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/memtag.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "threads/vmalloc.h"
+
+#define PAGE_CNT 257
+
+/* Returns the pages charged to MEM_FILESYS, through int 0x46. */
+static int64_t
+pages (void)
+{
+  int64_t value;
+
+  asm volatile ("int $0x46" : "=a" (value) : "d" (MEM_FILESYS), "c" (2));
+  return value;
+}
+
+void
+test_vmalloc (void)
+{
+  int64_t pages0 = pages ();
+  uint8_t *a, *b, *c;
+  size_t i;
+  bool zeroed = true, intact = true;
+
+  a = vmalloc (PAGE_CNT * PGSIZE - 1, PAL_ZERO | PAL_TAG (MEM_FILESYS));
+  if (a == NULL)
+    fail ("vmalloc failed");
+  msg ("in vmalloc region: %s", is_vmalloc_addr (a) ? "yes" : "no");
+  msg ("pages charged: %lld", (long long) (pages () - pages0));
+
+  for (i = 0; i < PAGE_CNT * PGSIZE - 1; i++)
+    if (a[i] != 0)
+      zeroed = false;
+  msg ("zeroed: %s", zeroed ? "yes" : "no");
+
+  for (i = 0; i < PAGE_CNT * PGSIZE - 1; i++)
+    a[i] = i / PGSIZE + i;
+  for (i = 0; i < PAGE_CNT * PGSIZE - 1; i++)
+    if (a[i] != (uint8_t) (i / PGSIZE + i))
+      intact = false;
+  msg ("contents intact: %s", intact ? "yes" : "no");
+
+  b = vmalloc (PGSIZE, PAL_TAG (MEM_FILESYS));
+  if (b == NULL)
+    fail ("vmalloc failed");
+  msg ("second area clear of first and its guard: %s",
+       b >= a + (PAGE_CNT + 1) * PGSIZE || b + 2 * PGSIZE <= a ? "yes" : "no");
+
+  vfree (a);
+  vfree (b);
+  msg ("after vfree: %lld pages charged", (long long) (pages () - pages0));
+
+  c = vmalloc (PAGE_CNT * PGSIZE, PAL_TAG (MEM_FILESYS));
+  msg ("freed space reused: %s", c == a ? "yes" : "no");
+  vfree (c);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(vmalloc) begin
+(vmalloc) in vmalloc region: yes
+(vmalloc) pages charged: 257
+(vmalloc) zeroed: yes
+(vmalloc) contents intact: yes
+(vmalloc) second area clear of first and its guard: yes
+(vmalloc) after vfree: 0 pages charged
+(vmalloc) freed space reused: yes
+(vmalloc) end
+EOF
+pass;
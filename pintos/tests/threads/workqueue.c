@@ -0,0 +1,106 @@
+/* Checks the kernel workqueue.
+
+   Items queued on a high-priority queue run ahead of items on a
+   low-priority queue, items on one queue run in FIFO order,
+   queue_work() refuses an item that is already pending, and
+   flush_work() / flush_workqueue() wait for completion. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+
+#define ITEM_CNT 8
+
+static struct work items[ITEM_CNT];
+static int log[ITEM_CNT];
+static int log_cnt;
+
+static struct semaphore blocker_sema;
+static bool slow_done;
+
+static void record_item (struct work *);
+static void blocker_item (struct work *);
+static void slow_item (struct work *);
+
+void
+test_workqueue (void) 
+{
+  static struct workqueue low_wq, high_wq;
+  struct work blocker, dup, slow;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  workqueue_create (&low_wq, "low", PRI_DEFAULT - 5);
+  workqueue_create (&high_wq, "high", PRI_DEFAULT + 5);
+
+  /* Items 0...3 go on the low queue, 4...7 on the high queue. */
+  for (i = 0; i < ITEM_CNT; i++)
+    {
+      work_init (&items[i], record_item);
+      queue_work (i < ITEM_CNT / 2 ? &low_wq : &high_wq, &items[i]);
+    }
+  flush_workqueue (&low_wq);
+  flush_workqueue (&high_wq);
+
+  if (log_cnt != ITEM_CNT)
+    fail ("%d items ran, expected %d", log_cnt, ITEM_CNT);
+  for (i = 0; i < ITEM_CNT; i++)
+    {
+      int expected = (i + ITEM_CNT / 2) % ITEM_CNT;
+      if (log[i] != expected)
+        fail ("item %d ran in position %d, expected item %d",
+              log[i], i, expected);
+    }
+  msg ("high-priority items ran first, each queue in order");
+
+  /* Keep the low queue busy so that DUP stays pending. */
+  sema_init (&blocker_sema, 0);
+  work_init (&blocker, blocker_item);
+  work_init (&dup, record_item);
+  queue_work (&low_wq, &blocker);
+  if (!queue_work (&low_wq, &dup))
+    fail ("queue_work refused an idle item");
+  if (queue_work (&low_wq, &dup))
+    fail ("queue_work accepted an item that was already pending");
+  sema_up (&blocker_sema);
+  flush_workqueue (&low_wq);
+  msg ("pending item was not queued twice");
+
+  work_init (&slow, slow_item);
+  queue_work (&system_wq, &slow);
+  flush_work (&slow);
+  if (!slow_done)
+    fail ("flush_work returned before the item finished");
+  msg ("flush_work waited for the item");
+  pass ();
+}
+
+/* Appends this item's index to the log. */
+static void
+record_item (struct work *w) 
+{
+  enum intr_level old_level = intr_disable ();
+  if (w >= items && w < items + ITEM_CNT && log_cnt < ITEM_CNT)
+    log[log_cnt++] = w - items;
+  intr_set_level (old_level);
+}
+
+static void
+blocker_item (struct work *w UNUSED) 
+{
+  sema_down (&blocker_sema);
+}
+
+static void
+slow_item (struct work *w UNUSED) 
+{
+  timer_sleep (10);
+  slow_done = true;
+}
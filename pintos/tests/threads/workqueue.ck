@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workqueue) begin
+(workqueue) high-priority items ran first, each queue in order
+(workqueue) pending item was not queued twice
+(workqueue) flush_work waited for the item
+(workqueue) PASS
+(workqueue) end
+EOF
+pass;
@@ -0,0 +1,54 @@
+/* Checks that read() into a buffer that fork shared copy-on-write
+   stays private to the process that made the call, in both
+   directions. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/sample.inc"
+
+static char buf[sizeof sample];
+
+static void
+read_sample (void)
+{
+	int handle;
+
+	CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+	CHECK (read (handle, buf, sizeof sample - 1) == sizeof sample - 1,
+	       "read \"sample.txt\"");
+	close (handle);
+}
+
+void
+test_main (void)
+{
+	pid_t child;
+
+	/* Make the buffer resident so that fork shares its frame. */
+	strlcpy (buf, "parent", sizeof buf);
+
+	child = fork ("child-read");
+	if (child == 0) {
+		read_sample ();
+		CHECK (memcmp (buf, sample, strlen (sample)) == 0,
+		       "child sees file data");
+		return;
+	}
+	wait (child);
+	CHECK (strcmp (buf, "parent") == 0, "parent buffer unchanged");
+
+	strlcpy (buf, "child", sizeof buf);
+	child = fork ("child-check");
+	if (child == 0) {
+		CHECK (strcmp (buf, "child") == 0, "child buffer unchanged");
+		return;
+	}
+	quiet = true;
+	read_sample ();
+	quiet = false;
+	wait (child);
+	CHECK (memcmp (buf, sample, strlen (sample)) == 0,
+	       "parent sees file data");
+}
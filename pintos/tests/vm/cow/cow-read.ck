@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(cow-read) begin
+(cow-read) open "sample.txt"
+(cow-read) read "sample.txt"
+(cow-read) child sees file data
+(cow-read) end
+(cow-read) parent buffer unchanged
+(cow-read) child buffer unchanged
+(cow-read) end
+(cow-read) parent sees file data
+(cow-read) end
+EOF
+pass;
@@ -0,0 +1,104 @@
+/* Checks that a fully populated, 2 MB aligned anonymous region is
+   promoted to one huge page, and that the huge page comes apart
+   correctly again.
+
+   The parent fills region A and checks that it ends up physically
+   contiguous and 2 MB aligned.  A child then writes every page of
+   A, which has to split the shared mapping for copy-on-write,
+   fills region B to get a huge page of its own, and exits, which
+   tears that huge page down with its page table.  Back in the
+   parent, A must be unchanged.  Last, the parent touches more
+   memory than the machine has, so that pages of A are evicted out
+   of their huge page, and checks A again once they are back. */
+
+#include <string.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define HUGE_SIZE (2 * 1024 * 1024)
+#define HUGE_PAGES (HUGE_SIZE / PAGE_SIZE)
+#define BIG_SIZE (16 * 1024 * 1024)
+
+/* Room for two aligned regions wherever the loader puts it. */
+static char area[3 * HUGE_SIZE];
+static char big[BIG_SIZE];
+
+/* Writes a pattern derived from SEED to both ends of every page
+   of REGION. */
+static void
+fill (char *region, int seed)
+{
+  size_t i;
+
+  for (i = 0; i < HUGE_PAGES; i++)
+    {
+      region[i * PAGE_SIZE] = (char) (i + seed);
+      region[i * PAGE_SIZE + PAGE_SIZE - 1] = (char) ~(i + seed);
+    }
+}
+
+/* Returns true if REGION holds the pattern fill() wrote with
+   SEED. */
+static bool
+holds (const char *region, int seed)
+{
+  size_t i;
+
+  for (i = 0; i < HUGE_PAGES; i++)
+    if (region[i * PAGE_SIZE] != (char) (i + seed)
+        || region[i * PAGE_SIZE + PAGE_SIZE - 1] != (char) ~(i + seed))
+      return false;
+  return true;
+}
+
+/* Returns true if REGION is backed by one physically contiguous,
+   2 MB aligned run of memory. */
+static bool
+is_huge (char *region)
+{
+  uintptr_t base = (uintptr_t) get_phys_addr (region);
+  size_t i;
+
+  if (base == 0 || base % HUGE_SIZE != 0)
+    return false;
+  for (i = 1; i < HUGE_PAGES; i++)
+    if ((uintptr_t) get_phys_addr (region + i * PAGE_SIZE)
+        != base + i * PAGE_SIZE)
+      return false;
+  return true;
+}
+
+void
+test_main (void)
+{
+  char *a = (char *) (((uintptr_t) area + HUGE_SIZE - 1)
+                      & ~(uintptr_t) (HUGE_SIZE - 1));
+  char *b = a + HUGE_SIZE;
+  pid_t child;
+  size_t i;
+
+  fill (a, 0);
+  CHECK (is_huge (a), "region A is one huge page");
+
+  child = fork ("child");
+  if (child == 0)
+    {
+      CHECK (holds (a, 0), "child sees parent's data in A");
+      fill (a, 1);
+      CHECK (holds (a, 1), "child's writes to A stick");
+      fill (b, 2);
+      CHECK (is_huge (b), "region B is one huge page");
+      CHECK (holds (b, 2), "child's data in B is intact");
+      exit (0);
+    }
+  CHECK (wait (child) == 0, "wait for child");
+  CHECK (holds (a, 0), "parent's data in A is unchanged");
+
+  msg ("touch %d MB to force eviction", BIG_SIZE / (1024 * 1024));
+  for (i = 0; i < BIG_SIZE; i += PAGE_SIZE)
+    big[i] = (char) i;
+  CHECK (holds (a, 0), "data in A survives eviction");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(huge-page) begin
+(huge-page) region A is one huge page
+(huge-page) child sees parent's data in A
+(huge-page) child's writes to A stick
+(huge-page) region B is one huge page
+(huge-page) child's data in B is intact
+(huge-page) wait for child
+(huge-page) parent's data in A is unchanged
+(huge-page) touch 16 MB to force eviction
+(huge-page) data in A survives eviction
+(huge-page) end
+EOF
+pass;
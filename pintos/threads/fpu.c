@@ -0,0 +1,239 @@
+#include "threads/fpu.h"
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "intrinsic.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* CR0 and CR4 bits.  See [IA32-v3a] 2.5 "Control Registers". */
+#define CR0_MP (1 << 1)         /* Monitor coprocessor: WAIT honors TS. */
+#define CR0_EM (1 << 2)         /* x87 emulation. */
+#define CR0_TS (1 << 3)         /* Task switched: next FPU use traps. */
+#define CR0_NE (1 << 5)         /* Native x87 error reporting. */
+#define CR4_OSFXSR (1 << 9)     /* FXSAVE/FXRSTOR and SSE enabled. */
+#define CR4_OSXMMEXCPT (1 << 10)/* Unmasked SIMD exceptions raise #XF. */
+#define CR4_OSXSAVE (1 << 18)   /* XSAVE and XGETBV/XSETBV enabled. */
+
+/* XCR0 state components.  We stop at AVX so that the save area
+   always fits in a single page. */
+#define XCR0_X87 (1 << 0)
+#define XCR0_SSE (1 << 1)
+#define XCR0_AVX (1 << 2)
+
+/* CPUID.1 feature bits. */
+#define CPUID_EDX_FXSR (1 << 24)
+#define CPUID_ECX_XSAVE (1 << 26)
+#define CPUID_ECX_AVX (1 << 28)
+
+/* Offsets into the legacy FXSAVE region. */
+#define FXSAVE_FCW 0
+#define FXSAVE_MXCSR 24
+
+/* Thread whose state is live in the FPU registers, or NULL. */
+static struct thread *fpu_owner;
+
+static bool fpu_enabled;        /* fpu_init() found FXSR. */
+static bool use_xsave;          /* XSAVE rather than FXSAVE. */
+static uint64_t xcr0;           /* State components we save. */
+static unsigned fpu_area_size;  /* Bytes of save area in use. */
+static bool ts_set;             /* Cached copy of CR0.TS. */
+
+static uint64_t
+rcr4 (void) {
+	uint64_t val;
+	__asm __volatile ("movq %%cr4, %0" : "=r" (val));
+	return val;
+}
+
+static void
+lcr4 (uint64_t val) {
+	__asm __volatile ("movq %0, %%cr4" : : "r" (val));
+}
+
+static void
+set_ts (void) {
+	if (!ts_set) {
+		lcr0 (rcr0 () | CR0_TS);
+		ts_set = true;
+	}
+}
+
+static void
+clear_ts (void) {
+	if (ts_set) {
+		__asm __volatile ("clts");
+		ts_set = false;
+	}
+}
+
+/* Saves the live FPU registers into AREA.  CR0.TS must be clear. */
+static void
+save_state (void *area) {
+	if (use_xsave)
+		__asm __volatile ("xsave64 (%0)"
+				: : "r" (area), "a" ((uint32_t) xcr0),
+				  "d" ((uint32_t) (xcr0 >> 32)) : "memory");
+	else
+		__asm __volatile ("fxsave64 (%0)" : : "r" (area) : "memory");
+}
+
+/* Loads the FPU registers from AREA.  CR0.TS must be clear. */
+static void
+restore_state (const void *area) {
+	if (use_xsave)
+		__asm __volatile ("xrstor64 (%0)"
+				: : "r" (area), "a" ((uint32_t) xcr0),
+				  "d" ((uint32_t) (xcr0 >> 32)) : "memory");
+	else
+		__asm __volatile ("fxrstor64 (%0)" : : "r" (area) : "memory");
+}
+
+/* Returns a save area holding the architectural initial state,
+   or NULL if out of memory.  The zeroed XSAVE header marks every
+   component as in its init state; only FCW and MXCSR are taken
+   from the legacy region and so must be filled in. */
+static void *
+alloc_area (void) {
+	uint8_t *area = palloc_get_page (PAL_ZERO);
+	if (area != NULL) {
+		*(uint16_t *) (area + FXSAVE_FCW) = 0x037f;
+		*(uint32_t *) (area + FXSAVE_MXCSR) = 0x1f80;
+	}
+	return area;
+}
+
+/* Enables SSE, and AVX through XSAVE when the CPU has it, and
+   arms CR0.TS so that the first FPU instruction traps. */
+void
+fpu_init (void) {
+	uint32_t a, b, c, d;
+
+	cpuid (1, 0, &a, &b, &c, &d);
+	if (!(d & CPUID_EDX_FXSR))
+		return;
+
+	lcr4 (rcr4 () | CR4_OSFXSR | CR4_OSXMMEXCPT);
+	fpu_area_size = 512;
+	if (c & CPUID_ECX_XSAVE) {
+		uint32_t sa, sb, sc, sd;
+
+		lcr4 (rcr4 () | CR4_OSXSAVE);
+		cpuid (0xd, 0, &sa, &sb, &sc, &sd);
+		xcr0 = XCR0_X87 | XCR0_SSE;
+		if ((c & CPUID_ECX_AVX) && (sa & XCR0_AVX))
+			xcr0 |= XCR0_AVX;
+		__asm __volatile ("xsetbv"
+				: : "c" (0), "a" ((uint32_t) xcr0),
+				  "d" ((uint32_t) (xcr0 >> 32)));
+
+		/* EBX now reports the size for the components enabled in
+		   XCR0. */
+		cpuid (0xd, 0, &sa, &sb, &sc, &sd);
+		fpu_area_size = sb;
+		use_xsave = true;
+	}
+	ASSERT (fpu_area_size <= PGSIZE);
+
+	lcr0 ((rcr0 () & ~CR0_EM) | CR0_MP | CR0_NE);
+	__asm __volatile ("fninit");
+	ts_set = false;
+	set_ts ();
+	fpu_enabled = true;
+}
+
+/* Called by the scheduler just before switching to NEXT.  Leaves
+   the FPU usable only if NEXT's state is the one loaded. */
+void
+fpu_switch (struct thread *next) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!fpu_enabled)
+		return;
+	if (next == fpu_owner)
+		clear_ts ();
+	else
+		set_ts ();
+}
+
+/* #NM handler body.  Evicts the current owner's state, if any,
+   and loads the running thread's, allocating its save area on
+   first use.  Returns false if the FPU is unavailable or the
+   save area cannot be allocated. */
+bool
+fpu_handle_trap (void) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	if (!fpu_enabled)
+		return false;
+
+	if (curr->fpu_area == NULL) {
+		/* palloc may sleep on its lock; nothing here depends on the
+		   FPU owner yet, so let it. */
+		old_level = intr_enable ();
+		curr->fpu_area = alloc_area ();
+		intr_set_level (old_level);
+		if (curr->fpu_area == NULL)
+			return false;
+	}
+
+	old_level = intr_disable ();
+	clear_ts ();
+	if (fpu_owner != curr) {
+		if (fpu_owner != NULL)
+			save_state (fpu_owner->fpu_area);
+		restore_state (curr->fpu_area);
+		fpu_owner = curr;
+	}
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Gives the running thread a copy of PARENT's FPU state, for
+   fork().  Returns false if out of memory. */
+bool
+fpu_fork (struct thread *parent) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	if (parent->fpu_area == NULL)
+		return true;
+
+	ASSERT (curr->fpu_area == NULL);
+	curr->fpu_area = alloc_area ();
+	if (curr->fpu_area == NULL)
+		return false;
+
+	old_level = intr_disable ();
+	if (fpu_owner == parent) {
+		/* PARENT's newest state is still in the registers.  Spill
+		   it; PARENT remains the owner, so we only borrow the FPU. */
+		clear_ts ();
+		save_state (parent->fpu_area);
+		set_ts ();
+	}
+	memcpy (curr->fpu_area, parent->fpu_area, fpu_area_size);
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Drops T's FPU state, e.g. on exec() or when T is destroyed. */
+void
+fpu_release (struct thread *t) {
+	enum intr_level old_level = intr_disable ();
+
+	if (fpu_owner == t) {
+		fpu_owner = NULL;
+		set_ts ();
+	}
+	intr_set_level (old_level);
+
+	if (t->fpu_area != NULL) {
+		palloc_free_page (t->fpu_area);
+		t->fpu_area = NULL;
+	}
+}
@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include "devices/lapic.h"
 #include "devices/timer.h"
 #include "intrinsic.h"
 #include "threads/flags.h"
@@ -92,15 +93,37 @@ static intr_handler_func *intr_handlers[INTR_CNT];
 static const char *intr_names[INTR_CNT];
 
 /* External interrupts are those generated by devices outside the
-   CPU, such as the timer.  External interrupts run with
-   interrupts turned off, so they never nest, nor are they ever
-   pre-empted.  Handlers for external interrupts also may not
-   sleep, although they may invoke intr_yield_on_return() to
-   request that a new process be scheduled just before the
-   interrupt returns. */
+   CPU, such as the timer, and delivered through the PICs (vectors
+   0x20...0x2f) or raised by the local APIC (0x30...0x3f).
+   External interrupts run with interrupts turned off, so they
+   never nest, nor are they ever pre-empted.  Handlers for
+   external interrupts also may not sleep, although they may
+   invoke intr_yield_on_return() to request that a new process be
+   scheduled just before the interrupt returns. */
 static bool in_external_intr; /* Are we processing an external interrupt? */
 static bool yield_on_return;  /* Should we yield on interrupt return? */
 
+/* Softirqs.  An external interrupt handler (the "top half") only
+   acknowledges its device and raises a softirq for the rest of
+   the work.  Raised softirqs (the "bottom halves") run at the end
+   of the outermost external interrupt, after the EOI, with
+   interrupts turned back on, before any yield.  So a long timer
+   wheel drain no longer holds off the other devices.
+
+   Bottom halves are still interrupt context: they may not sleep,
+   and they never nest.  An interrupt that arrives while they run
+   only raises more work, which the running loop picks up.  Work
+   that keeps re-raising itself is cut off after
+   SOFTIRQ_MAX_RESTART rounds and left pending for the next
+   interrupt. */
+#define SOFTIRQ_MAX_RESTART 10
+static softirq_func *softirq_handlers[SOFTIRQ_CNT];
+static unsigned softirq_pending; /* Bitmap of raised softirqs. */
+static bool in_softirq;          /* Running bottom halves? */
+
+/* Tasklets scheduled but not yet run, in FIFO order. */
+static struct list tasklets;
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init(void);
 static void pic_end_of_interrupt(int irq);
@@ -108,6 +131,10 @@ static void pic_end_of_interrupt(int irq);
 /* Interrupt handlers. */
 void intr_handler(struct intr_frame *args);
 
+/* Bottom halves. */
+static void softirq_run(void);
+static void tasklet_run(void);
+
 /* Returns the current interrupt status. */
 enum intr_level intr_get_level(void) {
   uint64_t flags;
@@ -127,10 +154,11 @@ enum intr_level intr_set_level(enum intr_level level) {
   return level == INTR_ON ? intr_enable() : intr_disable();
 }
 
-/* Enables interrupts and returns the previous interrupt status. */
+/* Enables interrupts and returns the previous interrupt status.
+   Bottom halves may do so; external interrupt handlers may not. */
 enum intr_level intr_enable(void) {
   enum intr_level old_level = intr_get_level();
-  ASSERT(!intr_context());
+  ASSERT(!in_external_intr);
 
   /* Enable interrupts by setting the interrupt flag.
 
@@ -194,6 +222,9 @@ void intr_init(void) {
   intr_names[17] = "#AC Alignment Check Exception";
   intr_names[18] = "#MC Machine-Check Exception";
   intr_names[19] = "#XF SIMD Floating-Point Exception";
+
+  list_init(&tasklets);
+  softirq_register(SOFTIRQ_TASKLET, tasklet_run);
 }
 
 /* Registers interrupt VEC_NO to invoke HANDLER with descriptor
@@ -217,7 +248,7 @@ static void register_handler(uint8_t vec_no, int dpl, enum intr_level level,
    execute with interrupts disabled. */
 void intr_register_ext(uint8_t vec_no, intr_handler_func *handler,
                        const char *name) {
-  ASSERT(vec_no >= 0x20 && vec_no <= 0x2f);
+  ASSERT(vec_no >= 0x20 && vec_no <= 0x3f);
   register_handler(vec_no, 0, INTR_OFF, handler, name);
 }
 
@@ -236,13 +267,13 @@ void intr_register_ext(uint8_t vec_no, intr_handler_func *handler,
    discussion. */
 void intr_register_int(uint8_t vec_no, int dpl, enum intr_level level,
                        intr_handler_func *handler, const char *name) {
-  ASSERT(vec_no < 0x20 || vec_no > 0x2f);
+  ASSERT(vec_no < 0x20 || vec_no > 0x3f);
   register_handler(vec_no, dpl, level, handler, name);
 }
 
-/* Returns true during processing of an external interrupt
-   and false at all other times. */
-bool intr_context(void) { return in_external_intr; }
+/* Returns true during processing of an external interrupt,
+   including its bottom halves, and false at all other times. */
+bool intr_context(void) { return in_external_intr || in_softirq; }
 
 /* During processing of an external interrupt, directs the
    interrupt handler to yield to a new process just before
@@ -253,6 +284,51 @@ void intr_yield_on_return(void) {
   yield_on_return = true;
 }
 
+/* Sets FUNC as the bottom half for softirq NR. */
+void softirq_register(enum softirq nr, softirq_func *func) {
+  ASSERT(nr < SOFTIRQ_CNT);
+  ASSERT(func != NULL);
+  softirq_handlers[nr] = func;
+}
+
+/* Marks softirq NR pending.  Called from an external interrupt
+   handler, its bottom half runs before that interrupt returns;
+   called elsewhere, it runs at the end of the next external
+   interrupt, at most a tick later. */
+void softirq_raise(enum softirq nr) {
+  ASSERT(nr < SOFTIRQ_CNT);
+  ASSERT(softirq_handlers[nr] != NULL);
+
+  enum intr_level old_level = intr_disable();
+  softirq_pending |= 1u << nr;
+  intr_set_level(old_level);
+}
+
+/* Initializes tasklet T to call FUNC (AUX). */
+void tasklet_init(struct tasklet *t, tasklet_func *func, void *aux) {
+  ASSERT(t != NULL);
+  ASSERT(func != NULL);
+
+  t->func = func;
+  t->aux = aux;
+  t->scheduled = false;
+}
+
+/* Queues tasklet T to run from the tasklet softirq.  Scheduling T
+   again before it has run does nothing, so a burst of interrupts
+   costs one call. */
+void tasklet_schedule(struct tasklet *t) {
+  ASSERT(t != NULL);
+
+  enum intr_level old_level = intr_disable();
+  if (!t->scheduled) {
+    t->scheduled = true;
+    list_push_back(&tasklets, &t->elem);
+    softirq_raise(SOFTIRQ_TASKLET);
+  }
+  intr_set_level(old_level);
+}
+
 /* 8259A Programmable Interrupt Controller. */
 
 /* Every PC has two 8259A Programmable Interrupt Controller (PIC)
@@ -311,26 +387,39 @@ static void pic_end_of_interrupt(int irq) {
    interrupted thread's registers. */
 void intr_handler(struct intr_frame *frame) {
   bool external;
+  bool from_user;
+  enum thread_acct acct = ACCT_CNT;
   intr_handler_func *handler;
 
   /* External interrupts are special.
      We only handle one at a time (so interrupts must be off)
-     and they need to be acknowledged on the PIC (see below).
-     An external interrupt handler cannot sleep. */
-  external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+     and they need to be acknowledged on the PIC or local APIC
+     (see below).  An external interrupt handler cannot sleep. */
+  external = frame->vec_no >= 0x20 && frame->vec_no < 0x40;
   if (external) {
     ASSERT(intr_get_level() == INTR_OFF);
-    ASSERT(!intr_context());
+    ASSERT(!in_external_intr);
 
     in_external_intr = true;
-    yield_on_return = false;
+    if (!in_softirq) yield_on_return = false;  // 하반부 도중이면 이미 요청된 yield를 지우지 않는다
+    acct = thread_acct_switch(ACCT_IRQ);  // 끝날 때까지의 사이클은 인터럽트 시간
+
+    /* Replay any ticks skipped while the idle thread was
+       tickless, before the handler looks at the clock. */
+    timer_idle_exit();
   }
 
+  /* Exceptions raised by user code (page faults, #NM, ...) are
+     kernel work done on the process's behalf. */
+  from_user = (frame->cs & 3) == 3;
+  if (!external && from_user) acct = thread_acct_switch(ACCT_SYS);
+
   /* Invoke the interrupt's handler. */
   handler = intr_handlers[frame->vec_no];
   if (handler != NULL)
     handler(frame);
-  else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f) {
+  else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f ||
+           frame->vec_no == LAPIC_SPURIOUS_VEC) {
     /* There is no handler, but this interrupt can trigger
        spuriously due to a hardware fault or hardware race
        condition.  Ignore it. */
@@ -344,12 +433,65 @@ void intr_handler(struct intr_frame *frame) {
   /* Complete the processing of an external interrupt. */
   if (external) {
     ASSERT(intr_get_level() == INTR_OFF);
-    ASSERT(intr_context());
+    ASSERT(in_external_intr);
 
     in_external_intr = false;
-    pic_end_of_interrupt(frame->vec_no);
+    if (frame->vec_no < 0x30)
+      pic_end_of_interrupt(frame->vec_no);
+    else if (frame->vec_no != LAPIC_SPURIOUS_VEC)  // 가짜 인터럽트는 EOI를 보내면 안 됨
+      lapic_eoi();
+
+    /* An interrupt that cut into the bottom halves leaves both
+       its softirqs and its yield to the outer invocation. */
+    if (!in_softirq) softirq_run();
+    thread_acct_switch(acct);
+
+    if (yield_on_return && !in_softirq) thread_yield();
+  } else if (acct != ACCT_CNT)
+    thread_acct_switch(acct);
+}
+
+/* Runs pending softirqs with interrupts on, until none remain or
+   SOFTIRQ_MAX_RESTART rounds have gone by.  Called with
+   interrupts off at the end of an external interrupt, and
+   returns with them off. */
+static void softirq_run(void) {
+  int restart = SOFTIRQ_MAX_RESTART;
+
+  ASSERT(intr_get_level() == INTR_OFF);
+  ASSERT(!in_softirq);
+
+  in_softirq = true;
+  while (softirq_pending != 0 && restart-- > 0) {
+    unsigned pending = softirq_pending;
+
+    softirq_pending = 0;
+    intr_enable();
+    for (int nr = 0; nr < SOFTIRQ_CNT; nr++)
+      if (pending & (1u << nr)) softirq_handlers[nr]();
+    intr_disable();
+  }
+  in_softirq = false;
+}
+
+/* Tasklet softirq: runs every tasklet scheduled so far, each with
+   interrupts on.  A tasklet may schedule itself again; it then
+   runs in a later round. */
+static void tasklet_run(void) {
+  struct list ready;
+
+  list_init(&ready);
+  enum intr_level old_level = intr_disable();
+  while (!list_empty(&tasklets)) list_push_back(&ready, list_pop_front(&tasklets));
+  intr_set_level(old_level);
+
+  while (!list_empty(&ready)) {
+    struct tasklet *t = list_entry(list_pop_front(&ready), struct tasklet, elem);
 
-    if (yield_on_return) thread_yield();
+    old_level = intr_disable();
+    t->scheduled = false;
+    intr_set_level(old_level);
+    t->func(t->aux);
   }
 }
 
@@ -5,9 +5,12 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "threads/vmalloc.h"
 
 
 /* A simple implementation of malloc().
@@ -33,14 +36,44 @@
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   the beginning of the allocated block's arena header.
+
+   In front of each descriptor's free list sits one "magazine"
+   per CPU: a small stack of free blocks.  malloc() pops and
+   free() pushes the current CPU's magazine with interrupts
+   briefly off, taking no lock.  Only when the magazine is empty
+   or full does it take the descriptor's lock, to move a batch of
+   blocks to or from the free list at once.  See J. Bonwick and
+   J. Adams, "Magazines and Vmem", USENIX 2001.  A block in a
+   magazine still counts as in use to its arena, so an arena
+   goes back to the page allocator only once none of its blocks
+   is cached.
+
+   Each block is charged to a memory accounting tag, given to
+   malloc_tagged(); plain malloc() uses MEM_OTHER.  An arena
+   records the tag of each of its blocks in a byte array after
+   its header, so that free() can find it again.  Arena pages
+   themselves are charged to MEM_MALLOC. */
+
+/* Magazine capacity, and blocks moved per refill or drain. */
+#define MAG_ROUNDS 32
+#define MAG_BATCH (MAG_ROUNDS / 2)
+
+/* Per-CPU cache of free blocks. */
+struct magazine {
+	size_t cnt;                 /* Number of blocks held. */
+	struct block *rounds[MAG_ROUNDS]; /* Blocks, most recently freed last. */
+};
 
 /* Descriptor. */
 struct desc {
 	size_t block_size;          /* Size of each element in bytes. */
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
+	size_t blocks_ofs;          /* Offset of first block in an arena. */
+	size_t arena_cnt;           /* Number of arenas. */
 	struct list free_list;      /* List of free blocks. */
 	struct lock lock;           /* Lock. */
+	struct magazine mags[CPU_MAX]; /* Per-CPU caches, no lock needed. */
 };
 
 /* Magic number for detecting arena corruption. */
@@ -49,8 +82,10 @@ struct desc {
 /* Arena. */
 struct arena {
 	unsigned magic;             /* Always set to ARENA_MAGIC. */
+	uint8_t tag;                /* Tag of big block. */
 	struct desc *desc;          /* Owning descriptor, null for big block. */
 	size_t free_cnt;            /* Free blocks; pages in big block. */
+	uint8_t tags[];             /* Tag of each block, if not big. */
 };
 
 /* Free block. */
@@ -64,6 +99,13 @@ static size_t desc_cnt;         /* Number of descriptors. */
 
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static size_t block_idx (struct arena *, struct block *);
+static size_t block_size (void *);
+static enum mem_tag block_tag (void *);
+static struct block *magazine_refill (struct desc *);
+static void magazine_drain (struct desc *, struct block *);
+static bool desc_grow (struct desc *);
+static void desc_release (struct desc *, struct block *[], size_t cnt);
 
 /* Initializes the malloc() descriptors. */
 void
@@ -72,11 +114,23 @@ malloc_init (void) {
 
 	for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2) {
 		struct desc *d = &descs[desc_cnt++];
+		size_t n;
+
 		ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
+
+		/* Fit as many blocks as possible after the header and
+		   one tag byte per block. */
+		n = (PGSIZE - sizeof (struct arena)) / (block_size + 1);
+		while (ROUND_UP (sizeof (struct arena) + n, sizeof (void *))
+				+ n * block_size > PGSIZE)
+			n--;
 		d->block_size = block_size;
-		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
+		d->blocks_per_arena = n;
+		d->blocks_ofs = ROUND_UP (sizeof (struct arena) + n, sizeof (void *));
+		d->arena_cnt = 0;
 		list_init (&d->free_list);
 		lock_init (&d->lock);
+		memset (d->mags, 0, sizeof d->mags);
 	}
 }
 
@@ -84,9 +138,18 @@ malloc_init (void) {
    Returns a null pointer if memory is not available. */
 void *
 malloc (size_t size) {
+	return malloc_tagged (size, MEM_OTHER);
+}
+
+/* Obtains and returns a new block of at least SIZE bytes, charged
+   to TAG.  Returns a null pointer if memory is not available. */
+void *
+malloc_tagged (size_t size, enum mem_tag tag) {
 	struct desc *d;
 	struct block *b;
 	struct arena *a;
+	struct magazine *mag;
+	enum intr_level old_level;
 
 	/* A null pointer satisfies a request for 0 bytes. */
 	if (size == 0)
@@ -99,48 +162,39 @@ malloc (size_t size) {
 			break;
 	if (d == descs + desc_cnt) {
 		/* SIZE is too big for any descriptor.
-		   Allocate enough pages to hold SIZE plus an arena. */
+		   Allocate enough pages to hold SIZE plus an arena.  If
+		   no run of pages is free that long, settle for pages
+		   that are only virtually contiguous. */
 		size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
-		a = palloc_get_multiple (0, page_cnt);
+		a = palloc_get_multiple (PAL_TAG (tag), page_cnt);
+		if (a == NULL)
+			a = vmalloc (page_cnt * PGSIZE, PAL_TAG (tag));
 		if (a == NULL)
 			return NULL;
 
 		/* Initialize the arena to indicate a big block of PAGE_CNT
 		   pages, and return it. */
 		a->magic = ARENA_MAGIC;
+		a->tag = tag;
 		a->desc = NULL;
 		a->free_cnt = page_cnt;
+		mem_charge (tag, block_size (a + 1), 0);
 		return a + 1;
 	}
 
-	lock_acquire (&d->lock);
-
-	/* If the free list is empty, create a new arena. */
-	if (list_empty (&d->free_list)) {
-		size_t i;
-
-		/* Allocate a page. */
-		a = palloc_get_page (0);
-		if (a == NULL) {
-			lock_release (&d->lock);
-			return NULL;
-		}
-
-		/* Initialize arena and add its blocks to the free list. */
-		a->magic = ARENA_MAGIC;
-		a->desc = d;
-		a->free_cnt = d->blocks_per_arena;
-		for (i = 0; i < d->blocks_per_arena; i++) {
-			struct block *b = arena_to_block (a, i);
-			list_push_back (&d->free_list, &b->free_elem);
-		}
+	/* Pop a block off this CPU's magazine, or refill it. */
+	old_level = intr_disable ();
+	mag = &d->mags[thread_cpu ()];
+	b = mag->cnt > 0 ? mag->rounds[--mag->cnt] : NULL;
+	intr_set_level (old_level);
+
+	if (b == NULL)
+		b = magazine_refill (d);
+	if (b != NULL) {
+		a = block_to_arena (b);
+		a->tags[block_idx (a, b)] = tag;
+		mem_charge (tag, d->block_size, 0);
 	}
-
-	/* Get a block from free list and return it. */
-	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-	a = block_to_arena (b);
-	a->free_cnt--;
-	lock_release (&d->lock);
 	return b;
 }
 
@@ -148,6 +202,14 @@ malloc (size_t size) {
    Returns a null pointer if memory is not available. */
 void *
 calloc (size_t a, size_t b) {
+	return calloc_tagged (a, b, MEM_OTHER);
+}
+
+/* Allocates and return A times B bytes initialized to zeroes,
+   charged to TAG.  Returns a null pointer if memory is not
+   available. */
+void *
+calloc_tagged (size_t a, size_t b, enum mem_tag tag) {
 	void *p;
 	size_t size;
 
@@ -157,7 +219,7 @@ calloc (size_t a, size_t b) {
 		return NULL;
 
 	/* Allocate and zero memory. */
-	p = malloc (size);
+	p = malloc_tagged (size, tag);
 	if (p != NULL)
 		memset (p, 0, size);
 
@@ -174,19 +236,31 @@ block_size (void *block) {
 	return d != NULL ? d->block_size : PGSIZE * a->free_cnt - pg_ofs (block);
 }
 
+/* Returns the tag that BLOCK is charged to. */
+static enum mem_tag
+block_tag (void *block) {
+	struct block *b = block;
+	struct arena *a = block_to_arena (b);
+
+	return a->desc != NULL ? a->tags[block_idx (a, b)] : a->tag;
+}
+
 /* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
    moving it in the process.
    If successful, returns the new block; on failure, returns a
    null pointer.
    A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
-   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK). */
+   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK).
+   The new block is charged to the same tag as OLD_BLOCK, or to
+   MEM_OTHER if OLD_BLOCK is null. */
 void *
 realloc (void *old_block, size_t new_size) {
 	if (new_size == 0) {
 		free (old_block);
 		return NULL;
 	} else {
-		void *new_block = malloc (new_size);
+		void *new_block = malloc_tagged (new_size,
+				old_block != NULL ? block_tag (old_block) : MEM_OTHER);
 		if (old_block != NULL && new_block != NULL) {
 			size_t old_size = block_size (old_block);
 			size_t min_size = new_size < old_size ? new_size : old_size;
@@ -206,6 +280,7 @@ free (void *p) {
 		struct arena *a = block_to_arena (b);
 		struct desc *d = a->desc;
 
+		mem_uncharge (block_tag (b), block_size (b), 0);
 		if (d != NULL) {
 			/* It's a normal block.  We handle it here. */
 
@@ -214,32 +289,179 @@ free (void *p) {
 			memset (b, 0xcc, d->block_size);
 #endif
 
-			lock_acquire (&d->lock);
+			/* Push it onto this CPU's magazine, or drain it. */
+			enum intr_level old_level = intr_disable ();
+			struct magazine *mag = &d->mags[thread_cpu ()];
+			bool cached = mag->cnt < MAG_ROUNDS;
 
-			/* Add block to free list. */
-			list_push_front (&d->free_list, &b->free_elem);
+			if (cached)
+				mag->rounds[mag->cnt++] = b;
+			intr_set_level (old_level);
 
-			/* If the arena is now entirely unused, free it. */
-			if (++a->free_cnt >= d->blocks_per_arena) {
-				size_t i;
-
-				ASSERT (a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++) {
-					struct block *b = arena_to_block (a, i);
-					list_remove (&b->free_elem);
-				}
-				palloc_free_page (a);
-			}
-
-			lock_release (&d->lock);
+			if (!cached)
+				magazine_drain (d, b);
 		} else {
 			/* It's a big block.  Free its pages. */
-			palloc_free_multiple (a, a->free_cnt);
+			if (is_vmalloc_addr (a))
+				vfree (a);
+			else
+				palloc_free_multiple (a, a->free_cnt);
 			return;
 		}
 	}
 }
 
+/* Prints the utilization of each descriptor's arenas. */
+void
+malloc_print_stats (void) {
+	struct desc *d;
+
+	for (d = descs; d < descs + desc_cnt; d++) {
+		size_t total, free_cnt, cached = 0;
+		enum intr_level old_level;
+		int cpu;
+
+		lock_acquire (&d->lock);
+		total = d->arena_cnt * d->blocks_per_arena;
+		free_cnt = list_size (&d->free_list);
+		old_level = intr_disable ();
+		for (cpu = 0; cpu < CPU_MAX; cpu++)
+			cached += d->mags[cpu].cnt;
+		intr_set_level (old_level);
+		lock_release (&d->lock);
+
+		if (total == 0)
+			continue;
+		printf ("malloc %zu: %zu arenas, %zu of %zu blocks in use (%zu%%), "
+				"%zu cached\n", d->block_size, d->arena_cnt,
+				total - free_cnt - cached, total,
+				(total - free_cnt - cached) * 100 / total, cached);
+	}
+}
+
+/* Slow path of malloc(): the current CPU's magazine for D is
+   empty.  Takes up to MAG_BATCH blocks from D's free list,
+   creating at most one new arena, returns one of them and loads
+   the rest into the magazine.  Returns a null pointer if memory
+   is not available. */
+static struct block *
+magazine_refill (struct desc *d) {
+	struct block *batch[MAG_BATCH];
+	struct magazine *mag;
+	enum intr_level old_level;
+	size_t cnt = 0;
+	size_t i;
+
+	lock_acquire (&d->lock);
+	while (cnt < MAG_BATCH) {
+		struct block *b;
+
+		/* Only grow when nothing else is free, so that large
+		   size classes do not grab several pages at once. */
+		if (list_empty (&d->free_list) && (cnt > 0 || !desc_grow (d)))
+			break;
+		b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
+		block_to_arena (b)->free_cnt--;
+		batch[cnt++] = b;
+	}
+	lock_release (&d->lock);
+	if (cnt == 0)
+		return NULL;
+
+	/* The magazine may have been refilled while we slept on the
+	   lock; whatever does not fit goes back. */
+	old_level = intr_disable ();
+	mag = &d->mags[thread_cpu ()];
+	for (i = 1; i < cnt && mag->cnt < MAG_ROUNDS; i++)
+		mag->rounds[mag->cnt++] = batch[i];
+	intr_set_level (old_level);
+	if (i < cnt)
+		desc_release (d, batch + i, cnt - i);
+
+	return batch[0];
+}
+
+/* Slow path of free(): the current CPU's magazine for D is full.
+   Returns B and the MAG_BATCH least recently freed blocks of the
+   magazine to D's free list. */
+static void
+magazine_drain (struct desc *d, struct block *b) {
+	struct block *batch[MAG_BATCH + 1];
+	struct magazine *mag;
+	enum intr_level old_level;
+	size_t cnt;
+	size_t i;
+
+	old_level = intr_disable ();
+	mag = &d->mags[thread_cpu ()];
+	cnt = mag->cnt < MAG_BATCH ? mag->cnt : MAG_BATCH;
+	for (i = 0; i < cnt; i++)
+		batch[i] = mag->rounds[i];
+	for (i = cnt; i < mag->cnt; i++)
+		mag->rounds[i - cnt] = mag->rounds[i];
+	mag->cnt -= cnt;
+	intr_set_level (old_level);
+
+	batch[cnt++] = b;
+	desc_release (d, batch, cnt);
+}
+
+/* Adds a new arena's worth of blocks to D's free list.  Returns
+   false if no page is available.  D's lock must be held. */
+static bool
+desc_grow (struct desc *d) {
+	struct arena *a;
+	size_t i;
+
+	ASSERT (lock_held_by_current_thread (&d->lock));
+
+	/* Allocate a page. */
+	a = palloc_get_page (PAL_TAG (MEM_MALLOC));
+	if (a == NULL)
+		return false;
+
+	/* Initialize arena and add its blocks to the free list. */
+	a->magic = ARENA_MAGIC;
+	a->desc = d;
+	a->free_cnt = d->blocks_per_arena;
+	d->arena_cnt++;
+	for (i = 0; i < d->blocks_per_arena; i++) {
+		struct block *b = arena_to_block (a, i);
+		list_push_back (&d->free_list, &b->free_elem);
+	}
+	return true;
+}
+
+/* Puts the CNT blocks in BLOCKS back on D's free list, freeing
+   any arena that becomes entirely unused. */
+static void
+desc_release (struct desc *d, struct block *blocks[], size_t cnt) {
+	size_t i;
+
+	lock_acquire (&d->lock);
+	for (i = 0; i < cnt; i++) {
+		struct block *b = blocks[i];
+		struct arena *a = block_to_arena (b);
+
+		/* Add block to free list. */
+		list_push_front (&d->free_list, &b->free_elem);
+
+		/* If the arena is now entirely unused, free it. */
+		if (++a->free_cnt >= d->blocks_per_arena) {
+			size_t j;
+
+			ASSERT (a->free_cnt == d->blocks_per_arena);
+			for (j = 0; j < d->blocks_per_arena; j++) {
+				struct block *b = arena_to_block (a, j);
+				list_remove (&b->free_elem);
+			}
+			d->arena_cnt--;
+			palloc_free_page (a);
+		}
+	}
+	lock_release (&d->lock);
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b) {
@@ -251,7 +473,7 @@ block_to_arena (struct block *b) {
 
 	/* Check that the block is properly aligned for the arena. */
 	ASSERT (a->desc == NULL
-			|| (pg_ofs (b) - sizeof *a) % a->desc->block_size == 0);
+			|| (pg_ofs (b) - a->desc->blocks_ofs) % a->desc->block_size == 0);
 	ASSERT (a->desc != NULL || pg_ofs (b) == sizeof *a);
 
 	return a;
@@ -264,6 +486,13 @@ arena_to_block (struct arena *a, size_t idx) {
 	ASSERT (a->magic == ARENA_MAGIC);
 	ASSERT (idx < a->desc->blocks_per_arena);
 	return (struct block *) ((uint8_t *) a
-			+ sizeof *a
+			+ a->desc->blocks_ofs
 			+ idx * a->desc->block_size);
 }
+
+/* Returns the index of block B within arena A. */
+static size_t
+block_idx (struct arena *a, struct block *b) {
+	ASSERT (a->desc != NULL);
+	return (pg_ofs (b) - a->desc->blocks_ofs) / a->desc->block_size;
+}
@@ -0,0 +1,140 @@
+#include "threads/memtag.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+
+/* Usage charged to one tag. */
+struct mem_usage {
+	size_t bytes;               /* Bytes in live objects. */
+	size_t bytes_peak;          /* Maximum of `bytes'. */
+	size_t pages;               /* Pages held. */
+	size_t pages_peak;          /* Maximum of `pages'. */
+};
+
+/* Usage by tag.  Updated with interrupts off, since allocations
+   may be freed from any thread. */
+static struct mem_usage usage[MEM_TAG_CNT];
+
+static const char *tag_names[MEM_TAG_CNT] = {
+	[MEM_OTHER] = "other",
+	[MEM_MALLOC] = "malloc",
+	[MEM_THREAD] = "thread",
+	[MEM_PROCESS] = "process",
+	[MEM_SYSCALL] = "syscall",
+	[MEM_VM] = "vm",
+	[MEM_FILESYS] = "filesys",
+};
+
+/* Charges BYTES bytes of objects and PAGES pages to TAG. */
+void
+mem_charge (enum mem_tag tag, size_t bytes, size_t pages) {
+	struct mem_usage *u;
+	enum intr_level old_level;
+
+	ASSERT (tag < MEM_TAG_CNT);
+
+	u = &usage[tag];
+	old_level = intr_disable ();
+	u->bytes += bytes;
+	if (u->bytes > u->bytes_peak)
+		u->bytes_peak = u->bytes;
+	u->pages += pages;
+	if (u->pages > u->pages_peak)
+		u->pages_peak = u->pages;
+	intr_set_level (old_level);
+}
+
+/* Gives back BYTES bytes of objects and PAGES pages previously
+   charged to TAG. */
+void
+mem_uncharge (enum mem_tag tag, size_t bytes, size_t pages) {
+	struct mem_usage *u;
+	enum intr_level old_level;
+
+	ASSERT (tag < MEM_TAG_CNT);
+
+	u = &usage[tag];
+	old_level = intr_disable ();
+	ASSERT (u->bytes >= bytes);
+	ASSERT (u->pages >= pages);
+	u->bytes -= bytes;
+	u->pages -= pages;
+	intr_set_level (old_level);
+}
+
+/* Returns TAG's name. */
+const char *
+mem_tag_name (enum mem_tag tag) {
+	ASSERT (tag < MEM_TAG_CNT);
+	return tag_names[tag];
+}
+
+/* Prints current and peak usage of each tag. */
+void
+mem_print_stats (void) {
+	enum mem_tag tag;
+
+	printf ("Memory by tag (current/peak):\n");
+	for (tag = 0; tag < MEM_TAG_CNT; tag++) {
+		const struct mem_usage *u = &usage[tag];
+
+		printf ("  %s: %zu/%zu bytes, %zu/%zu pages\n", tag_names[tag],
+				u->bytes, u->bytes_peak, u->pages, u->pages_peak);
+	}
+}
+
+/* Prints each tag that still has memory charged to it.  Called at
+   power off, when anything left is either held by a thread that
+   is still running or leaked. */
+void
+mem_print_leaks (void) {
+	enum mem_tag tag;
+	bool any = false;
+
+	for (tag = 0; tag < MEM_TAG_CNT; tag++) {
+		const struct mem_usage *u = &usage[tag];
+
+		if (u->bytes == 0 && u->pages == 0)
+			continue;
+		if (!any)
+			printf ("Memory still live at power off:\n");
+		printf ("  %s: %zu bytes, %zu pages\n",
+				tag_names[tag], u->bytes, u->pages);
+		any = true;
+	}
+	if (!any)
+		printf ("Memory still live at power off: none\n");
+}
+
+/* Returns one statistic of one tag. */
+static void
+inspect_mem (struct intr_frame *f) {
+	const struct mem_usage *u;
+
+	f->R.rax = -1;
+	if (f->R.rdx >= MEM_TAG_CNT)
+		return;
+
+	u = &usage[f->R.rdx];
+	switch (f->R.rcx) {
+		case 0: f->R.rax = u->bytes; break;
+		case 1: f->R.rax = u->bytes_peak; break;
+		case 2: f->R.rax = u->pages; break;
+		case 3: f->R.rax = u->pages_peak; break;
+	}
+}
+
+/* Tool for querying memory usage.  Calling this function via
+ * int 0x46.
+ * Input:
+ *   @RDX - tag, an enum mem_tag
+ *   @RCX - statistic: 0 bytes, 1 peak bytes, 2 pages, 3 peak pages
+ * Output:
+ *   @RAX - the statistic, or -1 if there is no such tag. */
+void
+register_mem_inspect_intr (void) {
+	intr_register_int (0x46, 3, INTR_OFF, inspect_mem, "Inspect Memory");
+}
@@ -23,6 +23,8 @@ pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 			} else
 				return NULL;
 		}
+		if (pdp[idx] & PTE_PS)
+			return &pdp[idx];
 		return (uint64_t *) ptov (PTE_ADDR (pdp[idx]) + 8 * PTX (va));
 	}
 	return NULL;
@@ -60,7 +62,9 @@ pdpe_walk (uint64_t *pdpe, const uint64_t va, int create) {
  * If PML4E does not have a page table for VADDR, behavior depends
  * on CREATE.  If CREATE is true, then a new page table is
  * created and a pointer into it is returned.  Otherwise, a null
- * pointer is returned. */
+ * pointer is returned.
+ * If VADDR lies in a huge page, returns its page directory entry,
+ * whose P, W, U, A and D bits have the same meaning. */
 uint64_t *
 pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 	uint64_t *pte = NULL;
@@ -88,6 +92,35 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 	return pte;
 }
 
+/* Returns the address of the page directory entry for virtual
+ * address VA in PML4.  If the page directory pointer table or the
+ * page directory does not exist, creates it if CREATE is true,
+ * otherwise returns a null pointer.  Also returns a null pointer
+ * if memory allocation fails. */
+static uint64_t *
+pde_walk (uint64_t *pml4, const uint64_t va, int create) {
+	uint64_t *table = pml4;
+	unsigned idx[2] = { PML4 (va), PDPE (va) };
+
+	for (int level = 0; level < 2; level++) {
+		uint64_t *e = &table[idx[level]];
+		if (!(*e & PTE_P)) {
+			uint64_t *new_page = create ? palloc_get_page (PAL_ZERO) : NULL;
+			if (new_page == NULL)
+				return NULL;
+			*e = vtop (new_page) | PTE_U | PTE_W | PTE_P;
+		}
+		table = ptov (PTE_ADDR (*e));
+	}
+	return &table[PDX (va)];
+}
+
+/* Returns true if PDE maps a huge page. */
+static bool
+pde_is_huge (uint64_t pde) {
+	return (pde & (PTE_P | PTE_PS)) == (PTE_P | PTE_PS);
+}
+
 /* Creates a new page map level 4 (pml4) has mappings for kernel
  * virtual addresses, but none for user virtual addresses.
  * Returns the new page directory, or a null pointer if memory
@@ -122,7 +155,13 @@ pgdir_for_each (uint64_t *pdp, pte_for_each_func *func, void *aux,
 		unsigned pml4_index, unsigned pdp_index) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
+		if (pde_is_huge (pdp[i])) {
+			void *va = (void *) (((uint64_t) pml4_index << PML4SHIFT) |
+								 ((uint64_t) pdp_index << PDPESHIFT) |
+								 ((uint64_t) i << PDXSHIFT));
+			if (!func (&pdp[i], va, aux))
+				return false;
+		} else if (((uint64_t) pte) & PTE_P)
 			if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
 					pml4_index, pdp_index, i))
 				return false;
@@ -143,7 +182,8 @@ pdp_for_each (uint64_t *pdp,
 	return true;
 }
 
-/* Apply FUNC to each available pte entries including kernel's. */
+/* Apply FUNC to each available pte entries including kernel's.
+ * A huge page is passed once, as its page directory entry. */
 bool
 pml4_for_each (uint64_t *pml4, pte_for_each_func *func, void *aux) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
@@ -169,7 +209,11 @@ static void
 pgdir_destroy (uint64_t *pdp) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
+		if (pde_is_huge (pdp[i])) {
+			uint8_t *kpage = ptov (PTE_ADDR (pdp[i]) & ~HPGMASK);
+			for (unsigned j = 0; j < HPG_PAGES; j++)
+				palloc_free_page (kpage + j * PGSIZE);
+		} else if (((uint64_t) pte) & PTE_P)
 			pt_destroy (PTE_ADDR (pte));
 	}
 	palloc_free_page ((void *) pdp);
@@ -214,6 +258,10 @@ void *
 pml4_get_page (uint64_t *pml4, const void *uaddr) {
 	ASSERT (is_user_vaddr (uaddr));
 
+	uint64_t *pde = pde_walk (pml4, (uint64_t) uaddr, 0);
+	if (pde && pde_is_huge (*pde))
+		return ptov (PTE_ADDR (*pde) & ~HPGMASK) + ((uint64_t) uaddr & HPGMASK);
+
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
 
 	if (pte && (*pte & PTE_P))
@@ -235,6 +283,7 @@ pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
 	ASSERT (pg_ofs (kpage) == 0);
 	ASSERT (is_user_vaddr (upage));
 	ASSERT (pml4 != base_pml4);
+	ASSERT (!pml4_is_huge (pml4, upage));
 
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) upage, 1);
 
@@ -243,9 +292,75 @@ pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
 	return pte != NULL;
 }
 
+/* Maps the HPGSIZE bytes at user virtual address UPAGE in PML4 to
+ * the physical memory at kernel virtual address KPAGE, as one
+ * huge page.  UPAGE and the physical address of KPAGE must be
+ * multiples of HPGSIZE.  Whatever was mapped in that range is
+ * replaced; a page table that mapped it is freed, but not the
+ * pages it mapped.
+ * If WRITABLE is true, the new page is read/write;
+ * otherwise it is read-only.
+ * Returns true if successful, false if memory allocation
+ * failed. */
+bool
+pml4_set_huge_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
+	ASSERT (((uint64_t) upage & HPGMASK) == 0);
+	ASSERT ((vtop (kpage) & HPGMASK) == 0);
+	ASSERT (is_user_vaddr (upage + HPGSIZE - 1));
+	ASSERT (pml4 != base_pml4);
+
+	uint64_t *pde = pde_walk (pml4, (uint64_t) upage, 1);
+
+	if (pde == NULL)
+		return false;
+	if ((*pde & PTE_P) && !(*pde & PTE_PS))
+		palloc_free_page (ptov (PTE_ADDR (*pde)));
+	*pde = vtop (kpage) | PTE_P | PTE_PS | (rw ? PTE_W : 0) | PTE_U;
+
+	/* The old entries may be cached for any of the small pages. */
+	if (rcr3 () == vtop (pml4))
+		lcr3 (vtop (pml4));
+	return true;
+}
+
+/* Replaces the huge page that contains UPAGE in PML4, if any, by
+ * a page table that maps the same memory as HPG_PAGES ordinary
+ * pages, each with the huge page's permissions and accessed and
+ * dirty bits.
+ * Returns false if memory allocation failed, true otherwise. */
+bool
+pml4_split_huge_page (uint64_t *pml4, void *upage) {
+	uint64_t *pde = pde_walk (pml4, (uint64_t) upage, 0);
+	uint64_t *pt, pa, flags;
+
+	if (pde == NULL || !pde_is_huge (*pde))
+		return true;
+
+	pt = palloc_get_page (0);
+	if (pt == NULL)
+		return false;
+	pa = PTE_ADDR (*pde) & ~HPGMASK;
+	flags = *pde & PTE_FLAGS & ~PTE_PS;
+	for (unsigned i = 0; i < HPG_PAGES; i++)
+		pt[i] = (pa + i * PGSIZE) | flags;
+	*pde = vtop (pt) | PTE_U | PTE_W | PTE_P;
+
+	if (rcr3 () == vtop (pml4))
+		invlpg ((uint64_t) hpg_round_down (upage));
+	return true;
+}
+
+/* Returns true if UPAGE lies in a huge page in PML4. */
+bool
+pml4_is_huge (uint64_t *pml4, const void *upage) {
+	uint64_t *pde = pde_walk (pml4, (uint64_t) upage, 0);
+	return pde != NULL && pde_is_huge (*pde);
+}
+
 /* Marks user virtual page UPAGE "not present" in page
  * directory PD.  Later accesses to the page will fault.  Other
- * bits in the page table entry are preserved.
+ * bits in the page table entry are preserved.  A huge page that
+ * contains UPAGE is split first, so that only UPAGE is affected.
  * UPAGE need not be mapped. */
 void
 pml4_clear_page (uint64_t *pml4, void *upage) {
@@ -253,6 +368,9 @@ pml4_clear_page (uint64_t *pml4, void *upage) {
 	ASSERT (pg_ofs (upage) == 0);
 	ASSERT (is_user_vaddr (upage));
 
+	if (!pml4_split_huge_page (pml4, upage))
+		PANIC ("pml4_clear_page: out of memory splitting huge page");
+
 	pte = pml4e_walk (pml4, (uint64_t) upage, false);
 
 	if (pte != NULL && (*pte & PTE_P) != 0) {
@@ -288,6 +406,39 @@ pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
 	}
 }
 
+/* Sets the writable bit to WRITABLE in the PTE for user virtual
+ * page VPAGE in PML4.  A huge page that contains VPAGE is split
+ * first, so that only VPAGE is affected.  The accessed and dirty
+ * bits are preserved.
+ * Returns false if memory allocation failed, true otherwise. */
+bool
+pml4_set_writable (uint64_t *pml4, const void *vpage, bool writable) {
+	uint64_t *pte;
+
+	if (!pml4_split_huge_page (pml4, (void *) vpage))
+		return false;
+
+	pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	if (pte) {
+		if (writable)
+			*pte |= PTE_W;
+		else
+			*pte &= ~(uint64_t) PTE_W;
+
+		if (rcr3 () == vtop (pml4))
+			invlpg ((uint64_t) vpage);
+	}
+	return true;
+}
+
+/* Returns true if the PTE for virtual page VPAGE in PML4 allows
+ * writes.  Returns false if PML4 contains no PTE for VPAGE. */
+bool
+pml4_is_writable (uint64_t *pml4, const void *vpage) {
+	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	return pte != NULL && (*pte & PTE_W) != 0;
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PML4 has been
  * accessed recently, that is, between the time the PTE was
  * installed and the last time it was cleared.  Returns false if
@@ -2,14 +2,17 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -24,15 +27,69 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is a binary buddy allocator.  Its free pages form
+   blocks of 2**ORDER pages, aligned to their size relative to the
+   pool base, kept on one free list per order.  An allocation of
+   N pages splits the smallest large enough block in halves down
+   to 2**ceil(lg N) pages and gives the unneeded tail back; a free
+   merges each block with its "buddy", the other half of the
+   block it was split from, for as long as that buddy is free.
+   Both take O(log n) time.  A free block's list element is kept
+   in its own first page.  See D. E. Knuth, "The Art of Computer
+   Programming", vol. 1, section 2.5.
+
+   In front of the buddy allocator, each pool also caches up to
+   ZERO_TARGET free pages that are already zeroed, so that a
+   single-page PAL_ZERO allocation skips the memset().  The
+   "pagezero" thread refills the cache at the lowest priority,
+   that is, when the CPU would otherwise idle.  Pages in the
+   cache count as in use to the buddy allocator.
+
+   A pool is protected by turning interrupts off rather than by a
+   lock, because the scheduler frees the pages of dying threads
+   from do_schedule(), where it must not sleep.  Every critical
+   section takes O(log n) time; memset() always runs outside. */
+
+/* Number of block orders: blocks of 1, 2, 4, ..., 1024 pages. */
+#define PAGE_ORDERS 11
+
+/* Value in `orders' for a page that does not start a free
+   block. */
+#define NOT_HEAD 0xff
+
+/* Pre-zeroed pages kept per pool, and the level below which an
+   allocation wakes the refill thread. */
+#define ZERO_TARGET 32
+#define ZERO_LOW (ZERO_TARGET / 2)
 
 /* A memory pool. */
 struct pool {
-	struct lock lock;               /* Mutual exclusion. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
 	uint8_t *base;                  /* Base of pool. */
+	uint8_t *orders;                /* Per page: order of the free block
+	                                   it starts, or NOT_HEAD. */
+	uint8_t *tags;                  /* Per page: tag of the allocation
+	                                   it starts. */
+	struct list free_lists[PAGE_ORDERS]; /* Free blocks by order. */
+	size_t free_cnt;                /* Number of free pages. */
+
+	void *zero_pages[ZERO_TARGET];  /* Free pages already zeroed. */
+	size_t zero_cnt;                /* Number of pages in zero_pages. */
+	uint64_t zero_hits;             /* PAL_ZERO pages from zero_pages. */
+	uint64_t zero_misses;           /* PAL_ZERO pages zeroed on demand. */
 };
 
+/* Upped when a pool's zeroed page cache runs low. */
+static struct semaphore zero_wanted;
+
+/* True while zero_wanted is up and the refill thread has not yet
+   woken, so that it is not upped again for every allocation.
+   Starts out true so that nothing ups zero_wanted before
+   palloc_zero_init() has initialized it. */
+static bool zero_pending = true;
+
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
@@ -42,6 +99,21 @@ static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static size_t pool_alloc (struct pool *, size_t page_cnt);
+static size_t pool_find_aligned (struct pool *, unsigned order,
+		size_t *block_idx, unsigned *block_order);
+static size_t pool_alloc_aligned (struct pool *, unsigned order);
+static void pool_free (struct pool *, size_t page_idx, size_t page_cnt);
+static void block_free (struct pool *, size_t page_idx, unsigned order);
+static void block_push (struct pool *, size_t page_idx, unsigned order);
+static void block_remove (struct pool *, size_t page_idx);
+static unsigned size_order (size_t page_cnt);
+static void pool_print_stats (const char *name, struct pool *);
+static void *zero_take (struct pool *);
+static void zero_drain (struct pool *);
+static void zero_wake (struct pool *);
+static bool zero_refill (struct pool *);
+static thread_func zero_thread;
 
 /* multiboot info */
 struct multiboot_info {
@@ -223,12 +295,12 @@ split:
 			page_idx = pg_no (start) - pg_no (pool->base);
 			if ((uint64_t) pool_end < end) {
 				page_cnt = ((uint64_t) pool_end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool_free (pool, page_idx, page_cnt);
 				start = (uint64_t) pool_end;
 				goto split;
 			} else {
 				page_cnt = ((uint64_t) end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool_free (pool, page_idx, page_cnt);
 			}
 		}
 	}
@@ -258,23 +330,55 @@ palloc_init (void) {
    otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
    then the pages are filled with zeros.  If too few pages are
    available, returns a null pointer, unless PAL_ASSERT is set in
-   FLAGS, in which case the kernel panics. */
+   FLAGS, in which case the kernel panics.  At most
+   2**(PAGE_ORDERS - 1) pages can be obtained at once.  The pages
+   are charged to the tag given by PAL_TAG in FLAGS. */
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-
-	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-	lock_release (&pool->lock);
-	void *pages;
-
-	if (page_idx != BITMAP_ERROR)
-		pages = pool->base + PGSIZE * page_idx;
-	else
-		pages = NULL;
+	void *pages = NULL;
+	bool zeroed = false;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	if ((flags & PAL_ZERO) && page_cnt == 1) {
+		pages = zero_take (pool);
+		zeroed = pages != NULL;
+		if (zeroed)
+			pool->zero_hits++;
+		else {
+			pool->zero_misses += page_cnt;
+			zero_wake (pool);
+		}
+	} else if (flags & PAL_ZERO)
+		pool->zero_misses += page_cnt;
+
+	if (pages == NULL) {
+		size_t page_idx = pool_alloc (pool, page_cnt);
+
+		/* Out of free blocks: fall back on the zeroed pages,
+		   either directly or by giving them back for a larger
+		   request. */
+		if (page_idx == BITMAP_ERROR && pool->zero_cnt > 0) {
+			if (page_cnt == 1)
+				pages = zero_take (pool);
+			else {
+				zero_drain (pool);
+				page_idx = pool_alloc (pool, page_cnt);
+			}
+		}
+		if (page_idx != BITMAP_ERROR)
+			pages = pool->base + PGSIZE * page_idx;
+	}
+	intr_set_level (old_level);
 
 	if (pages) {
-		if (flags & PAL_ZERO)
+		enum mem_tag tag = flags >> PAL_TAG_SHIFT;
+
+		ASSERT (tag < MEM_TAG_CNT);
+		pool->tags[pg_no (pages) - pg_no (pool->base)] = tag;
+		mem_charge (tag, 0, page_cnt);
+		if ((flags & PAL_ZERO) && !zeroed)
 			memset (pages, 0, PGSIZE * page_cnt);
 	} else {
 		if (flags & PAL_ASSERT)
@@ -296,11 +400,66 @@ palloc_get_page (enum palloc_flags flags) {
 	return palloc_get_multiple (flags, 1);
 }
 
+/* Obtains HPG_PAGES contiguous free pages whose physical address
+   is a multiple of HPGSIZE, suitable for mapping as one huge
+   page, and returns the kernel virtual address of the first.
+   Each page is an allocation of its own, to be freed with
+   palloc_free_page(), so that a huge page can later be split.
+   FLAGS are interpreted as for palloc_get_multiple(), except that
+   the zeroed page cache is not used. */
+void *
+palloc_get_huge_page (enum palloc_flags flags) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	enum mem_tag tag = flags >> PAL_TAG_SHIFT;
+	size_t page_idx;
+	void *pages;
+	enum intr_level old_level;
+
+	ASSERT (tag < MEM_TAG_CNT);
+
+	old_level = intr_disable ();
+	page_idx = pool_alloc_aligned (pool, size_order (HPG_PAGES));
+	intr_set_level (old_level);
+
+	if (page_idx == BITMAP_ERROR) {
+		if (flags & PAL_ASSERT)
+			PANIC ("palloc_get_huge_page: out of pages");
+		return NULL;
+	}
+
+	pages = pool->base + PGSIZE * page_idx;
+	memset (pool->tags + page_idx, tag, HPG_PAGES);
+	mem_charge (tag, 0, HPG_PAGES);
+	if (flags & PAL_ZERO)
+		memset (pages, 0, HPGSIZE);
+	return pages;
+}
+
+/* Returns true if palloc_get_huge_page (FLAGS) would find a free
+   aligned run right now.  Cheaper than the scan a caller may have
+   to do before it can use a huge page, but only a hint: the run
+   may be gone by the time it asks. */
+bool
+palloc_huge_available (enum palloc_flags flags) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	size_t block_idx;
+	unsigned block_order;
+	enum intr_level old_level;
+	bool available;
+
+	old_level = intr_disable ();
+	available = pool_find_aligned (pool, size_order (HPG_PAGES),
+			&block_idx, &block_order) != BITMAP_ERROR;
+	intr_set_level (old_level);
+	return available;
+}
+
 /* Frees the PAGE_CNT pages starting at PAGES. */
 void
 palloc_free_multiple (void *pages, size_t page_cnt) {
 	struct pool *pool;
 	size_t page_idx;
+	enum intr_level old_level;
 
 	ASSERT (pg_ofs (pages) == 0);
 	if (pages == NULL || page_cnt == 0)
@@ -314,12 +473,15 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 		NOT_REACHED ();
 
 	page_idx = pg_no (pages) - pg_no (pool->base);
+	mem_uncharge (pool->tags[page_idx], 0, page_cnt);
 
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
+	old_level = intr_disable ();
 	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	pool_free (pool, page_idx, page_cnt);
+	intr_set_level (old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -328,25 +490,333 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
-/* Initializes pool P as starting at START and ending at END */
+/* Starts the thread that keeps the pools' zeroed page caches
+   filled.  Until then, every PAL_ZERO allocation is zeroed on
+   demand. */
+void
+palloc_zero_init (void) {
+	sema_init (&zero_wanted, 1);
+	thread_create ("pagezero", PRI_MIN, zero_thread, NULL);
+}
+
+/* Prints the free memory and fragmentation of each pool. */
+void
+palloc_print_stats (void) {
+	pool_print_stats ("kernel pool", &kernel_pool);
+	pool_print_stats ("user pool", &user_pool);
+}
+
+/* Initializes pool P as starting at START and ending at END,
+   with every page in use. */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
+  /* We'll put the pool's used_map, followed by its orders and
+     tags arrays, at *BM_BASE.  Calculate the space needed for all
+     three and move *BM_BASE past them. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
-	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t bm_size = bitmap_buf_size (pgcnt);
+	size_t bm_pages = DIV_ROUND_UP (bm_size + 2 * pgcnt, PGSIZE) * PGSIZE;
+	unsigned order;
 
-	lock_init(&p->lock);
-	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
+	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_size);
 	p->base = (void *) start;
+	p->orders = (uint8_t *) *bm_base + bm_size;
+	p->tags = p->orders + pgcnt;
+	for (order = 0; order < PAGE_ORDERS; order++)
+		list_init (&p->free_lists[order]);
+	p->free_cnt = 0;
+	p->zero_cnt = 0;
+	p->zero_hits = p->zero_misses = 0;
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
+	memset (p->orders, NOT_HEAD, pgcnt);
+	memset (p->tags, MEM_OTHER, pgcnt);
 
 	*bm_base += bm_pages;
 }
 
+/* Takes PAGE_CNT contiguous pages out of POOL and returns the
+   index of the first, or BITMAP_ERROR if no free block is large
+   enough.  Interrupts must be off, unless during
+   initialization. */
+static size_t
+pool_alloc (struct pool *p, size_t page_cnt) {
+	unsigned want, order;
+	size_t page_idx;
+
+	if (page_cnt == 0 || page_cnt > (size_t) 1 << (PAGE_ORDERS - 1))
+		return BITMAP_ERROR;
+
+	/* Find the smallest free block that is large enough. */
+	want = size_order (page_cnt);
+	for (order = want; order < PAGE_ORDERS; order++)
+		if (!list_empty (&p->free_lists[order]))
+			break;
+	if (order == PAGE_ORDERS)
+		return BITMAP_ERROR;
+
+	page_idx = pg_no (list_front (&p->free_lists[order])) - pg_no (p->base);
+	block_remove (p, page_idx);
+
+	/* Split it, giving the upper halves back, until it is just
+	   large enough. */
+	while (order > want) {
+		order--;
+		block_push (p, page_idx + ((size_t) 1 << order), order);
+	}
+
+	/* Give back the unneeded tail of a non-power-of-2 request. */
+	p->free_cnt -= (size_t) 1 << want;
+	if (page_cnt < (size_t) 1 << want)
+		pool_free (p, page_idx + page_cnt, ((size_t) 1 << want) - page_cnt);
+
+	ASSERT (bitmap_none (p->used_map, page_idx, page_cnt));
+	bitmap_set_multiple (p->used_map, page_idx, page_cnt, true);
+	return page_idx;
+}
+
+/* Finds 2**ORDER contiguous free pages in POOL whose physical
+   address is aligned to their size, which buddy blocks are only
+   if the pool itself starts so aligned.  Returns the index of the
+   first, or BITMAP_ERROR if no free block contains such a run.
+   The free block that holds the run is stored in *BLOCK_IDX and
+   *BLOCK_ORDER.  Interrupts must be off. */
+static size_t
+pool_find_aligned (struct pool *p, unsigned order,
+		size_t *block_idx, unsigned *block_order) {
+	size_t cnt = (size_t) 1 << order;
+	size_t skew = pg_no (vtop (p->base)) % cnt;
+	unsigned o;
+
+	for (o = order; o < PAGE_ORDERS; o++) {
+		struct list *l = &p->free_lists[o];
+		struct list_elem *e;
+
+		for (e = list_begin (l); e != list_end (l); e = list_next (e)) {
+			size_t idx = pg_no (e) - pg_no (p->base);
+			size_t page_idx = idx + (cnt - (idx + skew) % cnt) % cnt;
+
+			if (page_idx + cnt <= idx + ((size_t) 1 << o)) {
+				*block_idx = idx;
+				*block_order = o;
+				return page_idx;
+			}
+		}
+	}
+	return BITMAP_ERROR;
+}
+
+/* Takes 2**ORDER contiguous pages out of POOL whose physical
+   address is aligned to their size, and returns the index of the
+   first, or BITMAP_ERROR if no free block contains such a run.
+   The rest of the block it is carved from is given back.
+   Interrupts must be off. */
+static size_t
+pool_alloc_aligned (struct pool *p, unsigned order) {
+	size_t cnt = (size_t) 1 << order;
+	size_t block_idx, block_cnt;
+	unsigned block_order;
+	size_t page_idx = pool_find_aligned (p, order, &block_idx, &block_order);
+
+	if (page_idx == BITMAP_ERROR)
+		return BITMAP_ERROR;
+	block_cnt = (size_t) 1 << block_order;
+
+	/* Take the whole block, then give back what lies before and
+	   after the aligned run. */
+	block_remove (p, block_idx);
+	p->free_cnt -= block_cnt;
+	if (page_idx > block_idx)
+		pool_free (p, block_idx, page_idx - block_idx);
+	if (page_idx + cnt < block_idx + block_cnt)
+		pool_free (p, page_idx + cnt,
+				block_idx + block_cnt - (page_idx + cnt));
+
+	ASSERT (bitmap_none (p->used_map, page_idx, cnt));
+	bitmap_set_multiple (p->used_map, page_idx, cnt, true);
+	return page_idx;
+}
+
+/* Returns PAGE_CNT pages starting at PAGE_IDX to POOL, as the
+   largest aligned blocks that cover them.  Interrupts must be
+   off, unless during initialization. */
+static void
+pool_free (struct pool *p, size_t page_idx, size_t page_cnt) {
+	bitmap_set_multiple (p->used_map, page_idx, page_cnt, false);
+	p->free_cnt += page_cnt;
+
+	while (page_cnt > 0) {
+		unsigned order = 0;
+
+		while (order + 1 < PAGE_ORDERS
+				&& page_idx % ((size_t) 2 << order) == 0
+				&& page_cnt >= (size_t) 2 << order)
+			order++;
+		block_free (p, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
+
+/* Frees the block of 2**ORDER pages at PAGE_IDX, merging it with
+   its buddy as long as the buddy is free too. */
+static void
+block_free (struct pool *p, size_t page_idx, unsigned order) {
+	size_t pgcnt = bitmap_size (p->used_map);
+
+	while (order + 1 < PAGE_ORDERS) {
+		size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+		if (buddy + ((size_t) 1 << order) > pgcnt || p->orders[buddy] != order)
+			break;
+		block_remove (p, buddy);
+		page_idx &= ~((size_t) 1 << order);
+		order++;
+	}
+	block_push (p, page_idx, order);
+}
+
+/* Puts the free block of 2**ORDER pages at PAGE_IDX on its free
+   list. */
+static void
+block_push (struct pool *p, size_t page_idx, unsigned order) {
+	struct list_elem *e = (struct list_elem *) (p->base + PGSIZE * page_idx);
+
+	ASSERT (page_idx % ((size_t) 1 << order) == 0);
+	p->orders[page_idx] = order;
+	list_push_front (&p->free_lists[order], e);
+}
+
+/* Takes the free block at PAGE_IDX off its free list. */
+static void
+block_remove (struct pool *p, size_t page_idx) {
+	struct list_elem *e = (struct list_elem *) (p->base + PGSIZE * page_idx);
+
+	ASSERT (p->orders[page_idx] != NOT_HEAD);
+	p->orders[page_idx] = NOT_HEAD;
+	list_remove (e);
+}
+
+/* Returns the smallest ORDER such that 2**ORDER >= PAGE_CNT. */
+static unsigned
+size_order (size_t page_cnt) {
+	unsigned order = 0;
+
+	while (((size_t) 1 << order) < page_cnt)
+		order++;
+	return order;
+}
+
+/* Prints POOL's free pages, its free blocks by order, and its
+   external fragmentation: the share of free pages that are not
+   in a block of the largest free size, and so cannot serve a
+   request of that size. */
+static void
+pool_print_stats (const char *name, struct pool *p) {
+	size_t blocks[PAGE_ORDERS];
+	size_t free_cnt, largest = 0;
+	unsigned order;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	free_cnt = p->free_cnt;
+	for (order = 0; order < PAGE_ORDERS; order++) {
+		blocks[order] = list_size (&p->free_lists[order]);
+		if (blocks[order] > 0)
+			largest = order;
+	}
+	intr_set_level (old_level);
+
+	printf ("%s: %zu free pages, largest block %zu pages, "
+			"%zu%% fragmented\n", name, free_cnt, (size_t) 1 << largest,
+			free_cnt > 0
+			? 100 - (blocks[largest] << largest) * 100 / free_cnt : 0);
+	printf ("%s: free blocks by order:", name);
+	for (order = 0; order < PAGE_ORDERS; order++)
+		printf (" %zu", blocks[order]);
+	printf ("\n");
+	printf ("%s: %"PRIu64" PAL_ZERO hits, %"PRIu64" misses, "
+			"%zu pre-zeroed pages\n",
+			name, p->zero_hits, p->zero_misses, p->zero_cnt);
+}
+
+/* Takes a page from POOL's zeroed page cache, or returns a null
+   pointer if it is empty.  Wakes the refill thread when the cache
+   runs low.  Interrupts must be off. */
+static void *
+zero_take (struct pool *p) {
+	void *page = NULL;
+
+	if (p->zero_cnt > 0)
+		page = p->zero_pages[--p->zero_cnt];
+	zero_wake (p);
+	return page;
+}
+
+/* Gives every page in POOL's zeroed page cache back to the buddy
+   allocator, and wakes the refill thread to build it up again once
+   memory is freed.  Interrupts must be off. */
+static void
+zero_drain (struct pool *p) {
+	while (p->zero_cnt > 0) {
+		uint8_t *page = p->zero_pages[--p->zero_cnt];
+		pool_free (p, pg_no (page) - pg_no (p->base), 1);
+	}
+	zero_wake (p);
+}
+
+/* Wakes the refill thread if POOL's zeroed page cache is low and
+   the thread has not been woken already.  Interrupts must be
+   off. */
+static void
+zero_wake (struct pool *p) {
+	if (p->zero_cnt <= ZERO_LOW && !zero_pending) {
+		zero_pending = true;
+		sema_up (&zero_wanted);
+	}
+}
+
+/* Zeroes one free page of POOL and adds it to the zeroed page
+   cache.  Returns false if the cache is full or POOL has no free
+   page.  The memset() runs with interrupts on. */
+static bool
+zero_refill (struct pool *p) {
+	size_t page_idx;
+	uint8_t *page;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	page_idx = p->zero_cnt < ZERO_TARGET ? pool_alloc (p, 1) : BITMAP_ERROR;
+	intr_set_level (old_level);
+	if (page_idx == BITMAP_ERROR)
+		return false;
+
+	page = p->base + PGSIZE * page_idx;
+	memset (page, 0, PGSIZE);
+
+	old_level = intr_disable ();
+	if (p->zero_cnt < ZERO_TARGET)
+		p->zero_pages[p->zero_cnt++] = page;
+	else
+		pool_free (p, page_idx, 1);
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Refill thread.  Runs at PRI_MIN and with the least favorable
+   nice, so it only gets the CPU when nothing else wants it. */
+static void
+zero_thread (void *aux UNUSED) {
+	thread_set_nice (NICE_MAX);
+	for (;;) {
+		sema_down (&zero_wanted);
+		zero_pending = false;
+		while (zero_refill (&kernel_pool) | zero_refill (&user_pool))
+			continue;
+	}
+}
+
 /* Returns true if PAGE was allocated from POOL,
    false otherwise. */
 static bool
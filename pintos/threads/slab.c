@@ -0,0 +1,288 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* A slab allocator.
+
+   Each cache carves one-page "slabs" into objects of exactly the
+   requested size, rounded up only to 8 bytes for alignment.  A
+   slab starts with a header, followed by a stack holding the
+   indexes of its free objects, followed by the objects.  Keeping
+   the free list outside the objects means that freeing an object
+   does not overwrite it, which is what lets a constructor run
+   once per object instead of once per allocation.  See J.
+   Bonwick, "The Slab Allocator: An Object-Caching Kernel Memory
+   Allocator", USENIX Summer 1994.
+
+   A cache keeps its slabs on three lists: full, partially used,
+   and empty.  Allocation prefers a partial slab, so that objects
+   pack into as few pages as possible.  At most one empty slab is
+   kept to absorb an alloc/free cycle at the boundary; further
+   empty slabs go straight back to the page allocator.
+
+   kmem_cache_free() finds an object's slab by rounding its
+   address down to a page boundary, just as free() finds an
+   arena. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab0bec
+
+/* Object cache. */
+struct kmem_cache {
+	const char *name;           /* Name, for statistics. */
+	size_t obj_size;            /* Requested object size. */
+	size_t stride;              /* Distance between objects. */
+	size_t objs_per_slab;       /* Number of objects in a slab. */
+	size_t first_ofs;           /* Offset of first object in a slab. */
+	kmem_ctor *ctor;            /* Constructor, or null. */
+	enum mem_tag tag;           /* Tag charged for objects and slabs. */
+	struct lock lock;           /* Protects everything below. */
+	struct list full;           /* Slabs with no free object. */
+	struct list partial;        /* Slabs with some free objects. */
+	struct list empty;          /* Slabs with no object in use. */
+	size_t slab_cnt;            /* Number of slabs. */
+	size_t in_use;              /* Objects allocated. */
+	uint64_t allocs;            /* Calls to kmem_cache_alloc(). */
+	uint64_t frees;             /* Calls to kmem_cache_free(). */
+	struct list_elem elem;      /* Element in `caches'. */
+};
+
+/* Slab header, at the start of each slab's page. */
+struct slab {
+	unsigned magic;             /* Always set to SLAB_MAGIC. */
+	struct kmem_cache *cache;   /* Owning cache. */
+	struct list_elem elem;      /* Element in one of CACHE's lists. */
+	size_t free_cnt;            /* Number of free objects. */
+	uint16_t free[];            /* Indexes of free objects, a stack. */
+};
+
+/* All caches, in creation order.  Caches are created at boot and
+   never destroyed. */
+static struct list caches = {{NULL, &caches.tail}, {&caches.head, NULL}};
+
+static struct slab *slab_create (struct kmem_cache *);
+static struct slab *obj_to_slab (struct kmem_cache *, void *);
+static void *slab_obj (struct kmem_cache *, struct slab *, size_t idx);
+
+/* Creates and returns a cache, named NAME, of SIZE-byte objects.
+   If CTOR is nonnull, it is run on each object when the object's
+   slab is created.  Objects and slabs are charged to TAG.  Panics
+   if SIZE is too big for one object to fit in a page, or if memory
+   is not available. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, kmem_ctor *ctor,
+		enum mem_tag tag) {
+	struct kmem_cache *c;
+	size_t n;
+
+	ASSERT (name != NULL);
+	ASSERT (size > 0);
+
+	c = malloc (sizeof *c);
+	if (c == NULL)
+		PANIC ("kmem_cache_create: out of memory for %s cache", name);
+
+	/* Fit as many objects as possible after the header and the
+	   free stack. */
+	c->name = name;
+	c->obj_size = size;
+	c->stride = ROUND_UP (size, sizeof (uint64_t));
+	n = (PGSIZE - sizeof (struct slab)) / (c->stride + sizeof (uint16_t));
+	while (n > 0 && ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t),
+				sizeof (uint64_t)) + n * c->stride > PGSIZE)
+		n--;
+	if (n == 0)
+		PANIC ("kmem_cache_create: %zu-byte %s objects do not fit in a slab",
+				size, name);
+	c->objs_per_slab = n;
+	c->first_ofs = ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t),
+			sizeof (uint64_t));
+	c->ctor = ctor;
+	c->tag = tag;
+	lock_init_named (&c->lock, name);
+	list_init (&c->full);
+	list_init (&c->partial);
+	list_init (&c->empty);
+	c->slab_cnt = 0;
+	c->in_use = 0;
+	c->allocs = 0;
+	c->frees = 0;
+	list_push_back (&caches, &c->elem);
+	return c;
+}
+
+/* Allocates and returns an object from cache C.  Returns a null
+   pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c) {
+	struct slab *s;
+	void *obj;
+
+	ASSERT (c != NULL);
+
+	lock_acquire (&c->lock);
+	if (!list_empty (&c->partial))
+		s = list_entry (list_front (&c->partial), struct slab, elem);
+	else if (!list_empty (&c->empty)) {
+		s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+		list_push_front (&c->partial, &s->elem);
+	} else {
+		s = slab_create (c);
+		if (s == NULL) {
+			lock_release (&c->lock);
+			return NULL;
+		}
+		list_push_front (&c->partial, &s->elem);
+	}
+
+	ASSERT (s->free_cnt > 0);
+	obj = slab_obj (c, s, s->free[--s->free_cnt]);
+	if (s->free_cnt == 0) {
+		list_remove (&s->elem);
+		list_push_front (&c->full, &s->elem);
+	}
+	c->in_use++;
+	c->allocs++;
+	lock_release (&c->lock);
+	mem_charge (c->tag, c->obj_size, 0);
+
+	return obj;
+}
+
+/* Allocates and returns a zeroed object from cache C, which must
+   not have a constructor.  Returns a null pointer if memory is
+   not available. */
+void *
+kmem_cache_zalloc (struct kmem_cache *c) {
+	void *obj;
+
+	ASSERT (c != NULL);
+	ASSERT (c->ctor == NULL);
+
+	obj = kmem_cache_alloc (c);
+	if (obj != NULL)
+		memset (obj, 0, c->obj_size);
+	return obj;
+}
+
+/* Returns OBJ, which must have been allocated from cache C, to
+   C.  Does nothing if OBJ is a null pointer. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj) {
+	struct slab *s;
+
+	ASSERT (c != NULL);
+	if (obj == NULL)
+		return;
+
+	s = obj_to_slab (c, obj);
+	mem_uncharge (c->tag, c->obj_size, 0);
+#ifndef NDEBUG
+	/* Clear the object to help detect use-after-free bugs.  A
+	   constructed object must keep its state. */
+	if (c->ctor == NULL)
+		memset (obj, 0xcc, c->obj_size);
+#endif
+
+	lock_acquire (&c->lock);
+	ASSERT (s->free_cnt < c->objs_per_slab);
+	s->free[s->free_cnt++] = ((uint8_t *) obj - ((uint8_t *) s + c->first_ofs))
+		/ c->stride;
+	c->in_use--;
+	c->frees++;
+
+	if (s->free_cnt == c->objs_per_slab) {
+		/* Slab is now unused.  Keep one, free the rest. */
+		list_remove (&s->elem);
+		if (list_empty (&c->empty))
+			list_push_front (&c->empty, &s->elem);
+		else {
+			s->magic = 0;
+			c->slab_cnt--;
+			palloc_free_page (s);
+		}
+	} else if (s->free_cnt == 1) {
+		/* Slab was full. */
+		list_remove (&s->elem);
+		list_push_front (&c->partial, &s->elem);
+	}
+	lock_release (&c->lock);
+}
+
+/* Prints statistics about each cache. */
+void
+kmem_print_stats (void) {
+	struct list_elem *e;
+
+	for (e = list_begin (&caches); e != list_end (&caches); e = list_next (e)) {
+		struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+
+		lock_acquire (&c->lock);
+		printf ("slab %s: %zu-byte objects, %zu per slab, %zu slabs, "
+				"%zu in use, %"PRIu64" allocs, %"PRIu64" frees\n",
+				c->name, c->obj_size, c->objs_per_slab, c->slab_cnt,
+				c->in_use, c->allocs, c->frees);
+		lock_release (&c->lock);
+	}
+}
+
+/* Obtains a page for a new slab of cache C and constructs its
+   objects.  Returns a null pointer if no page is available.  C's
+   lock must be held. */
+static struct slab *
+slab_create (struct kmem_cache *c) {
+	struct slab *s;
+	size_t i;
+
+	ASSERT (lock_held_by_current_thread (&c->lock));
+
+	s = palloc_get_page (PAL_TAG (c->tag));
+	if (s == NULL)
+		return NULL;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = c;
+	s->free_cnt = c->objs_per_slab;
+
+	/* Lowest-addressed objects are handed out first. */
+	for (i = 0; i < c->objs_per_slab; i++) {
+		s->free[i] = c->objs_per_slab - 1 - i;
+		if (c->ctor != NULL)
+			c->ctor (slab_obj (c, s, i));
+	}
+	c->slab_cnt++;
+	return s;
+}
+
+/* Returns the slab of cache C that OBJ is inside. */
+static struct slab *
+obj_to_slab (struct kmem_cache *c, void *obj) {
+	struct slab *s = pg_round_down (obj);
+
+	/* Check that the slab is valid and belongs to C. */
+	ASSERT (s != NULL);
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT (s->cache == c);
+
+	/* Check that the object is properly aligned for the slab. */
+	ASSERT (pg_ofs (obj) >= c->first_ofs);
+	ASSERT ((pg_ofs (obj) - c->first_ofs) % c->stride == 0);
+
+	return s;
+}
+
+/* Returns the IDX'th object within slab S of cache C. */
+static void *
+slab_obj (struct kmem_cache *c, struct slab *s, size_t idx) {
+	ASSERT (idx < c->objs_per_slab);
+	return (uint8_t *) s + c->first_ofs + idx * c->stride;
+}
@@ -28,12 +28,29 @@
 
 #include "threads/synch.h"
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "intrinsic.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
+/* Every lock given a name by lock_init_named(), in creation
+   order.  Statically initialized, since locks may be named
+   before any init function runs.  Interrupts must be off to
+   access it. */
+static struct list named_locks = {{NULL, &named_locks.tail}, {&named_locks.head, NULL}};
+
+/* Number of locks lock_print_stats() reports. */
+#define LOCK_STATS_TOP 8
+
+static bool sema_waiter_less(const struct heap_elem *, const struct heap_elem *, void *aux);
+static bool donor_less(const struct heap_elem *, const struct heap_elem *, void *aux);
+static void donor_enter(struct lock *);
+static void donor_leave(struct lock *);
+static size_t lock_top_contended(struct lock *top[], size_t cnt);
+
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
    manipulating it:
@@ -47,7 +64,52 @@ void sema_init(struct semaphore *sema, unsigned value) {
   ASSERT(sema != NULL);
 
   sema->value = value;
-  list_init(&sema->waiters);
+  heap_init(&sema->waiters, sema_waiter_less, NULL);
+  sema->epoch = thread_decay_epoch();
+}
+
+/* Arrival counter for wait heaps.  Among waiters of equal
+   priority the one that arrived first wins, as with a FIFO
+   list. */
+static uint64_t next_wait_seq;
+
+/* sema waiters 힙 비교 함수: 우선순위가 높을수록, 같으면 먼저 온 쓰레드가 위로 */
+static bool sema_waiter_less(const struct heap_elem *a_, const struct heap_elem *b_, void *aux UNUSED) {
+  const struct thread *a = heap_entry(a_, struct thread, wait_elem);
+  const struct thread *b = heap_entry(b_, struct thread, wait_elem);
+
+  if (a->priority != b->priority) return a->priority < b->priority;
+  return a->wait_seq > b->wait_seq;
+}
+
+/* sema waiters 힙 노드 -> 기다리는 쓰레드 */
+static struct thread *sema_waiter_thread(struct heap_elem *e) {
+  return heap_entry(e, struct thread, wait_elem);
+}
+
+/* Under mlfqs, waiters' priorities go stale as their recent_cpu
+   decays while they sleep.  On the first wake-up of each decay
+   epoch, settles every thread in WAITERS and rebuilds the heap by
+   the new priorities, then records the epoch in *EPOCH.
+   THREAD_OF maps a heap element to its waiting thread.  A lone
+   waiter needs no reordering; thread_unblock() settles it.
+   Interrupts must be off. */
+static void waiters_settle(struct heap *waiters, int64_t *epoch, struct thread *(*thread_of)(struct heap_elem *)) {
+  struct heap settled;
+
+  ASSERT(intr_get_level() == INTR_OFF);
+  if (!thread_mlfqs || *epoch == thread_decay_epoch()) return;
+  *epoch = thread_decay_epoch();
+  if (heap_size(waiters) < 2) return;
+
+  heap_init(&settled, waiters->less, waiters->aux);
+  while (!heap_empty(waiters)) {
+    struct heap_elem *e = heap_pop(waiters);
+
+    mlfqs_settle(thread_of(e));
+    heap_push(&settled, e);
+  }
+  *waiters = settled;  // 원소들은 힙 구조체를 가리키지 않으므로 그대로 옮겨도 됨
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -65,10 +127,18 @@ void sema_down(struct semaphore *sema) {
   ASSERT(!intr_context());
 
   old_level = intr_disable();
-  while (sema->value == 0) {  // sema_up에서 최댓값을 가져오므로 넣을때는 끝에서부터 걍 넣자
-    list_push_back(&sema->waiters, &thread_current()->elem);
-
+  while (sema->value == 0) {  // 우선순위 힙에 넣고, sema_up이 최댓값을 꺼내 깨움
+    struct thread *curr = thread_current();
+    bool tracked = curr->wait_heap == NULL;  // cond_wait 중이면 조건변수 힙 쪽에서 재정렬됨
+
+    curr->wait_seq = next_wait_seq++;
+    heap_push(&sema->waiters, &curr->wait_elem);
+    if (tracked) {
+      curr->wait_heap = &sema->waiters;
+      curr->wait_node = &curr->wait_elem;
+    }
     thread_block();
+    if (tracked) curr->wait_heap = NULL;
   }
   sema->value--;
   intr_set_level(old_level);
@@ -108,11 +178,11 @@ void sema_up(struct semaphore *sema) {
   old_level = intr_disable();
 
   sema->value++;  // good
-  if (!list_empty(&sema->waiters)) {
-    // sema->waiters 중에서 우선순위 최댓값인거 가져와야 함. 비교함수가 반대여서 min을 씀...(최댓값뽑는게맞음)
-    struct list_elem *max_elem = list_min(&sema->waiters, thread_priority_less, NULL);
-    struct thread *t = list_entry(max_elem, struct thread, elem);
-    list_remove(max_elem);  // 삭제까지 해줘야함 원래 pop이었으니까
+  waiters_settle(&sema->waiters, &sema->epoch, sema_waiter_thread);
+  if (!heap_empty(&sema->waiters)) {
+    // 힙 top이 우선순위 최댓값 (같으면 먼저 온 쓰레드), O(log n)
+    struct thread *t = heap_entry(heap_pop(&sema->waiters), struct thread, wait_elem);
+    if (t->wait_heap == &sema->waiters) t->wait_heap = NULL;
     thread_unblock(t);
   }
   intr_set_level(old_level);
@@ -149,6 +219,7 @@ static void sema_test_helper(void *sema_) {
   }
 }
 
+
 /* Initializes LOCK.  A lock can be held by at most a single
    thread at any given time.  Our locks are not "recursive", that
    is, it is an error for the thread currently holding a lock to
@@ -169,9 +240,121 @@ void lock_init(struct lock *lock) {
 
   lock->holder = NULL;
   sema_init(&lock->semaphore, 1);
+  heap_init(&lock->donors, donor_less, NULL);
+  lock->max_priority = PRI_MIN - 1;
+  lock->name = NULL;
+  memset(&lock->stats, 0, sizeof lock->stats);
+}
+
+/* Initializes LOCK like lock_init() and profiles it under NAME:
+   from now on its contention statistics are kept and reported by
+   lock_print_stats().  LOCK must stay valid until the kernel
+   shuts down. */
+void lock_init_named(struct lock *lock, const char *name) {
+  ASSERT(name != NULL);
+
+  lock_init(lock);
+  lock->name = name;
+
+  enum intr_level old_level = intr_disable();
+  list_push_back(&named_locks, &lock->stats_elem);
+  intr_set_level(old_level);
+}
+
+/* donors 힙 비교 함수: 우선순위가 높은 쓰레드가 위로 */
+static bool donor_less(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED) {
+  return heap_entry(a, struct thread, donor_elem)->priority < heap_entry(b, struct thread, donor_elem)->priority;
+}
+
+/* Recomputes T's effective priority.  If it changed and T is
+   itself waiting on a lock, returns that lock so the caller can
+   carry the change on to its holder; otherwise returns NULL.
+   T's key in the lock's donor heap is refreshed by removing and
+   reinserting it. */
+static struct lock *thread_refresh_priority(struct thread *t) {
+  int priority = thread_effective_priority(t);
+  struct lock *waiting = t->waiting_for_lock;
+
+  if (priority == t->priority) return NULL;
+
+  if (waiting != NULL) heap_remove(&waiting->donors, &t->donor_elem);
+  thread_set_effective_priority(t, priority);  // ready 상태라면 새 우선순위의 큐로 옮겨짐
+  if (waiting != NULL) heap_push(&waiting->donors, &t->donor_elem);
+  return waiting;
+}
+
+/* LOCK's set of donors changed.  Walks the chain LOCK -> holder
+   -> lock the holder waits on -> ..., updating each cached
+   priority, and stops as soon as one does not change.  Each hop
+   costs O(log n), and there is no depth limit. */
+static void donation_propagate(struct lock *lock) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  while (lock != NULL) {
+    struct thread *holder = lock->holder;
+    int priority = PRI_MIN - 1;
+
+    if (!heap_empty(&lock->donors))
+      priority = heap_entry(heap_top(&lock->donors), struct thread, donor_elem)->priority;
+    if (priority == lock->max_priority) return;
+
+    if (holder == NULL) {  // 방금 풀려서 아직 새 주인이 없는 경우
+      lock->max_priority = priority;
+      return;
+    }
+    heap_remove(&holder->held_locks, &lock->holder_elem);
+    lock->max_priority = priority;
+    heap_push(&holder->held_locks, &lock->holder_elem);
+
+    lock = thread_refresh_priority(holder);  // 다음 체인: holder가 기다리는 락
+  }
+}
+
+/* The current thread is about to block until LOCK's holder lets
+   it go.  Adds it to LOCK's donors and donates its priority along
+   the holder chain. */
+static void donor_enter(struct lock *lock) {
+  struct thread *curr = thread_current();
+
+  ASSERT(intr_get_level() == INTR_OFF);
+  ASSERT(curr->waiting_for_lock == NULL);
+
+  if (thread_mlfqs) return;  // mlfqs에서는 기부하지 않음
+
+  curr->waiting_for_lock = lock;
+  heap_push(&lock->donors, &curr->donor_elem);
+  donation_propagate(lock);
+}
+
+/* Undoes donor_enter(), if it took effect, once the current
+   thread stops waiting on LOCK. */
+static void donor_leave(struct lock *lock) {
+  struct thread *curr = thread_current();
+
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (curr->waiting_for_lock != lock) return;
+
+  heap_remove(&lock->donors, &curr->donor_elem);
+  curr->waiting_for_lock = NULL;
+  donation_propagate(lock);  // holder가 없으면 max_priority만 갱신됨
+}
+
+/* Makes the current thread LOCK's holder, once the semaphore has
+   been downed.  Remaining waiters keep donating to the new
+   holder. */
+static void lock_take(struct lock *lock) {
+  struct thread *curr = thread_current();
+
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  lock->holder = curr;
+  if (thread_mlfqs) return;  // mlfqs에서는 기부하지 않음
+
+  heap_push(&curr->held_locks, &lock->holder_elem);  // 보유중인 락에 추가
+  thread_refresh_priority(curr);
 }
 
-static void donate_priority_dfs(struct thread *holder, int prioirty);
 /* Acquires LOCK, sleeping until it becomes available if
    necessary.  The lock must not already be held by the current
    thread.
@@ -186,61 +369,34 @@ void lock_acquire(struct lock *lock) {  // P 함수의 wrapper, 해당 락을 
   ASSERT(!lock_held_by_current_thread(lock));
 
   enum intr_level old_level = intr_disable();
-  struct thread *curr = thread_current();
+  bool contended = lock->semaphore.value == 0;
+  uint64_t start = lock->name != NULL ? rdtsc() : 0;
 
-  // priority donate nested
-  if (lock->holder != NULL) {
-    donate_priority_dfs(lock->holder, curr->priority);  // 해당 lock의 holder부터 시작해서 dfs로 우선순위 donate
-  }
+  // priority donate nested: 내 우선순위를 donors에 넣고 holder 체인을 따라 전파
+  // holder가 막 풀고 아직 새 주인이 깨어나지 않은 경우에도 기부해 두면 새 주인이 물려받음
+  if (contended) donor_enter(lock);
 
-  curr->waiting_for_lock = lock;  //쓰레드 waiting_for_lock 필드 갱신
-
-  intr_set_level(old_level);
   sema_down(&lock->semaphore);  // 여기서 block 당함
 
   /* 락 획득 후 처리 */
-  old_level = intr_disable();     // 인터럽트 끄기(전역 데이터를 수정하기 때문에)
-  curr->waiting_for_lock = NULL;  // 이젠 이 락에 대해선 안 기다리니까
-  lock->holder = curr;            // 만약 뚫었다면 현재 스레드가 이 lock의 holder임
-  curr->is_donated += 1;          // 내가 락을 소유하게 되었으니 is_donated 추가
-  list_push_back(&curr->acquired_locks, &lock->holder_elem);  // 보유중인 락에 추가 이건 순서 상관없음
-  intr_set_level(old_level);                                  // 인터럽트 복원
-}
-static void donate_priority_dfs(struct thread *holder, int prioirty) {
-  int depth = 0;
-  const int MAX_DEPTH = 8;
-
-  struct thread *curr = holder;  // 첫 시작은 해당 락의 holder 부터
-
-  // struct thread* visited[MAX_DEPTH]; // 여태 방문한 thread를 저장
-  // int visited_count=0; //방문 횟수
-  while (curr != NULL && depth < MAX_DEPTH) {
-    // visited 배열을 순회하면서 현재 들어와 있는 쓰레드가 혹시 이미 방문했다면 false 반환
-    // for(int i=0;i<visited_count;i++)
-    //   if(visited[i]==curr) return false; // 순환발견, donation 중단
-
-    if (curr->priority >= prioirty)  //우선순위가 이미 높거나 같다면
-      break;                         //중단
-
-    // priority donation 수행
-    curr->priority = prioirty;
-
-    // ready_list에 있다면 재정렬
-    if (curr->status == THREAD_READY) {
-      list_remove(&curr->elem);
-      list_insert_ordered(get_ready_list(), &curr->elem, thread_priority_less, NULL);
+  donor_leave(lock);  // 이젠 이 락에 대해선 안 기다리니까 donors에서 빠짐
+  lock_take(lock);
+  if (lock->name != NULL) {  // 이름 붙은 락만 통계를 남긴다
+    struct lock_stats *st = &lock->stats;
+
+    st->acquired_at = rdtsc();
+    st->acquired++;
+    if (contended) {
+      uint64_t wait = st->acquired_at - start;
+
+      st->contended++;
+      st->wait_total += wait;
+      if (wait > st->wait_max) st->wait_max = wait;
     }
-
-    // 다음 체인 확인 : 이 스레드가 다른 락을 기다리고 있는가
-    if (curr->waiting_for_lock == NULL) {  // 다른 락을 기다리고 있지 않다면
-      break;                               // 중단
-    }
-
-    //다른 락을 기다리고 있다면 다음 holder로 이동
-    curr = curr->waiting_for_lock->holder;
-    depth++;
   }
+  intr_set_level(old_level);  // 인터럽트 복원
 }
+
 /* Tries to acquires LOCK and returns true if successful or false
    on failure.  The lock must not already be held by the current
    thread.
@@ -248,13 +404,22 @@ static void donate_priority_dfs(struct thread *holder, int prioirty) {
    This function will not sleep, so it may be called within an
    interrupt handler. */
 bool lock_try_acquire(struct lock *lock) {
+  enum intr_level old_level;
   bool success;
 
   ASSERT(lock != NULL);
   ASSERT(!lock_held_by_current_thread(lock));
 
+  old_level = intr_disable();
   success = sema_try_down(&lock->semaphore);
-  if (success) lock->holder = thread_current();
+  if (success) {
+    lock_take(lock);
+    if (lock->name != NULL) {
+      lock->stats.acquired_at = rdtsc();
+      lock->stats.acquired++;
+    }
+  }
+  intr_set_level(old_level);
   return success;
 }
 
@@ -271,27 +436,16 @@ void lock_release(struct lock *lock) {  // V함수의 wrapper
   enum intr_level old_level = intr_disable();
   struct thread *curr = thread_current();
 
-  //현재 쓰레드의 acquired locks에서 노드 제거
-  list_remove(&lock->holder_elem);
-
-  // 우선순위 복구 내가 가지고 있는 acquire lock 중에서 가장 큰 걸로 받아와야함
-  int new_priority = curr->original_priority;
-
-  struct list_elem *e;  // acquired locks를 순회하면서 각각의 락
-  // 현재 스레드가 보유중인 락을 순회 하면서 각 락의 우선순위 최댓값을 new_priority로 함(물론 내 original이 높다면
-  // 그걸로 채택)
-  for (e = list_begin(&curr->acquired_locks); e != list_end(&curr->acquired_locks); e = list_next(e)) {
-    struct lock *other_lock = list_entry(e, struct lock, holder_elem);
-
-    if (list_empty(&other_lock->semaphore.waiters)) continue;  // 대기자가 없는 락은 pass
-
-    struct thread *front_thread = list_entry(list_front(&other_lock->semaphore.waiters), struct thread, elem);
+  if (lock->name != NULL) {
+    uint64_t hold = rdtsc() - lock->stats.acquired_at;
+    if (hold > lock->stats.hold_max) lock->stats.hold_max = hold;
+  }
 
-    if (front_thread->priority > new_priority)  // 각 락의 우선순위 최댓값을 가지고 new_priority 갱신
-      new_priority = front_thread->priority;
+  // 보유 락 힙에서 빼고, 남은 락들의 최대 기부 우선순위로 복구 (O(log n))
+  if (!thread_mlfqs) {
+    heap_remove(&curr->held_locks, &lock->holder_elem);
+    thread_refresh_priority(curr);
   }
-  curr->priority = new_priority;  // 현재 스레드의 적절한 priority로 갱신
-  curr->is_donated -= 1;          // 내가 풀었으니까 is_donated 하나 내리기
 
   lock->holder = NULL;
   sema_up(&lock->semaphore);  // 자원 1 공급해주고 waiter 중 우선순위 높은 쓰레드 unblock
@@ -307,19 +461,114 @@ bool lock_held_by_current_thread(const struct lock *lock) {
   return lock->holder == thread_current();
 }
 
-/* One semaphore in a list. */
+/* Fills TOP with up to CNT named locks, most contended first,
+   and returns how many it found.  Ties go to the lock with more
+   total wait.  Interrupts must be off. */
+static size_t lock_top_contended(struct lock *top[], size_t cnt) {
+  size_t n = 0;
+
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  for (struct list_elem *e = list_begin(&named_locks); e != list_end(&named_locks); e = list_next(e)) {
+    struct lock *lock = list_entry(e, struct lock, stats_elem);
+    size_t i;
+
+    if (lock->stats.acquired == 0) continue;
+    // 삽입 정렬: 뒤에서부터 자리를 찾아 밀어낸다
+    for (i = n < cnt ? n++ : cnt; i > 0; i--) {
+      struct lock_stats *prev = &top[i - 1]->stats;
+      if (prev->contended > lock->stats.contended ||
+          (prev->contended == lock->stats.contended && prev->wait_total >= lock->stats.wait_total))
+        break;
+      if (i < cnt) top[i] = top[i - 1];
+    }
+    if (i < cnt) top[i] = lock;
+  }
+  return n;
+}
+
+/* Prints the LOCK_STATS_TOP most contended named locks. */
+void lock_print_stats(void) {
+  struct lock *top[LOCK_STATS_TOP];
+  size_t n;
+
+  enum intr_level old_level = intr_disable();
+  n = lock_top_contended(top, LOCK_STATS_TOP);
+  intr_set_level(old_level);
+
+  if (n == 0) return;
+  printf("Locks: top %zu by contention (TSC cycles)\n", n);
+  for (size_t i = 0; i < n; i++) {
+    const struct lock_stats *st = &top[i]->stats;
+
+    printf("  %s: %" PRIu64 " acquired, %" PRIu64 " contended, wait %" PRIu64 " avg %" PRIu64
+           " max, hold %" PRIu64 " max\n",
+           top[i]->name, st->acquired, st->contended, st->contended ? st->wait_total / st->contended : 0,
+           st->wait_max, st->hold_max);
+  }
+}
+
+/* Returns one statistic of a profiled lock, for testing. */
+static void inspect_lock_stats(struct intr_frame *f) {
+  struct lock *top[LOCK_STATS_TOP];
+  size_t n = lock_top_contended(top, LOCK_STATS_TOP);
+  const struct lock_stats *st;
+
+  f->R.rax = -1;
+  if (f->R.rdx >= n) return;
+
+  st = &top[f->R.rdx]->stats;
+  switch (f->R.rcx) {
+    case 0: f->R.rax = st->acquired; break;
+    case 1: f->R.rax = st->contended; break;
+    case 2: f->R.rax = st->wait_total; break;
+    case 3: f->R.rax = st->wait_max; break;
+    case 4: f->R.rax = st->hold_max; break;
+  }
+}
+
+/* Tool for measuring lock contention.  Calling this function via
+ * int 0x45.
+ * Input:
+ *   @RDX - rank of the lock, 0 for the most contended
+ *   @RCX - statistic: 0 acquired, 1 contended, 2 total wait,
+ *          3 max wait, 4 max hold
+ * Output:
+ *   @RAX - the statistic, or -1 if there is no such lock. */
+void register_lock_inspect_intr(void) {
+  intr_register_int(0x45, 3, INTR_OFF, inspect_lock_stats, "Inspect Lock Stats");
+}
+
+/* One semaphore in a condition variable's wait heap. */
 struct semaphore_elem {
-  struct list_elem elem;      /* List element. */
+  struct heap_elem elem;      /* Heap element. */
   struct semaphore semaphore; /* This semaphore. */
+  struct thread *thread;      /* Thread waiting on SEMAPHORE. */
+  uint64_t seq;               /* Arrival order, for FIFO among equals. */
 };
 
+/* cond waiters 힙 비교 함수: 기다리는 쓰레드의 우선순위가 높을수록, 같으면 먼저 온 쪽이 위로 */
+static bool cond_waiter_less(const struct heap_elem *a_, const struct heap_elem *b_, void *aux UNUSED) {
+  const struct semaphore_elem *a = heap_entry(a_, struct semaphore_elem, elem);
+  const struct semaphore_elem *b = heap_entry(b_, struct semaphore_elem, elem);
+
+  if (a->thread->priority != b->thread->priority) return a->thread->priority < b->thread->priority;
+  return a->seq > b->seq;
+}
+
+/* cond waiters 힙 노드 -> 기다리는 쓰레드 */
+static struct thread *cond_waiter_thread(struct heap_elem *e) {
+  return heap_entry(e, struct semaphore_elem, elem)->thread;
+}
+
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
    code to receive the signal and act upon it. */
 void cond_init(struct condition *cond) {
   ASSERT(cond != NULL);
 
-  list_init(&cond->waiters);
+  heap_init(&cond->waiters, cond_waiter_less, NULL);
+  cond->epoch = thread_decay_epoch();
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -350,8 +599,21 @@ void cond_wait(struct condition *cond, struct lock *lock) {  // 특정 조건에
   ASSERT(!intr_context());
   ASSERT(lock_held_by_current_thread(lock));
 
-  sema_init(&waiter.semaphore, 0);               // 새로만든 semaphore_elem을 초기화한다.
-  list_push_back(&cond->waiters, &waiter.elem);  // 새로만든 semaphore 를 cond에 추가한다.
+  struct thread *curr = thread_current();
+  enum intr_level old_level;
+
+  sema_init(&waiter.semaphore, 0);  // 새로만든 semaphore_elem을 초기화한다.
+  waiter.thread = curr;
+
+  // 새로만든 semaphore 를 cond 힙에 추가한다. lock_release로 기부가 빠지면서
+  // 우선순위가 바뀔 수 있으므로 이 힙에서 재정렬되도록 등록해 둔다.
+  old_level = intr_disable();
+  waiter.seq = next_wait_seq++;
+  heap_push(&cond->waiters, &waiter.elem);
+  curr->wait_heap = &cond->waiters;
+  curr->wait_node = &waiter.elem;
+  intr_set_level(old_level);
+
   lock_release(lock);  // 다른 사람이 들어올 수 있도록 lock을 열어 둔다(원자적 이동을 보장하기 위함)
   sema_down(&waiter.semaphore);  // 내 전용 semaphore가 풀릴 때까지 대기한다.(cond_signal이 풀어줌)
   lock_acquire(lock);            // 다른 스레드의 배타적 접근을 위해서 대기
@@ -370,32 +632,16 @@ void cond_signal(struct condition *cond, struct lock *lock UNUSED) {  // 조건
   ASSERT(!intr_context());
   ASSERT(lock_held_by_current_thread(lock));
 
-  if (!list_empty(&cond->waiters)) {
-    struct list_elem *max_elem = NULL;
-    int max_priority = -1;
-
-    // for문으로 가장 높은 우선순위 찾기
-    struct list_elem *e;
-    for (e = list_begin(&cond->waiters); e != list_end(&cond->waiters); e = list_next(e)) {
-      struct semaphore_elem *sema_elem = list_entry(e, struct semaphore_elem, elem);
-
-      // list_front 쓰기전에 원소가 있는지 없는지 먼저 확인할 것
-      if (list_empty(&sema_elem->semaphore.waiters)) continue;
-
-      // 대기 중인 쓰레드 중에서 가장 우선순위가 높은 쓰레드를 찾는다.
-      struct thread *waiting_thread = list_entry(list_front(&sema_elem->semaphore.waiters), struct thread, elem);
-      if (waiting_thread->priority > max_priority) {
-        max_priority = waiting_thread->priority;
-        max_elem = e;
-      }
-    }
-    if (max_elem != NULL) {  // 가장 우선순위 높은 쓰레드를 깨운다.
-      struct semaphore_elem *max_sema_elem = list_entry(max_elem, struct semaphore_elem, elem);
-      list_remove(max_elem);
-      // 해당 조건을 기다리는건 그 쓰레드 전용 semaphore를 기다리는 것으로 구현했으므로 semaphore를 풀어준다.
-      sema_up(&max_sema_elem->semaphore);
-    }
+  enum intr_level old_level = intr_disable();
+  waiters_settle(&cond->waiters, &cond->epoch, cond_waiter_thread);
+  if (!heap_empty(&cond->waiters)) {
+    // 기다리는 쓰레드 중 가장 우선순위 높은 (같으면 먼저 온) 쪽을 O(log n)에 꺼냄
+    struct semaphore_elem *waiter = heap_entry(heap_pop(&cond->waiters), struct semaphore_elem, elem);
+    waiter->thread->wait_heap = NULL;
+    // 해당 조건을 기다리는건 그 쓰레드 전용 semaphore를 기다리는 것으로 구현했으므로 semaphore를 풀어준다.
+    sema_up(&waiter->semaphore);
   }
+  intr_set_level(old_level);
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -408,5 +654,175 @@ void cond_broadcast(struct condition *cond, struct lock *lock) {
   ASSERT(cond != NULL);
   ASSERT(lock != NULL);
 
-  while (!list_empty(&cond->waiters)) cond_signal(cond, lock);
+  while (!heap_empty(&cond->waiters)) cond_signal(cond, lock);
+}
+
+/* Initializes RW as unlocked. */
+void rwlock_init(struct rwlock *rw) {
+  ASSERT(rw != NULL);
+
+  lock_init(&rw->write_lock);
+  rw->readers = 0;
+  rw->waiting_readers = 0;
+  rw->waiting_writers = 0;
+  sema_init(&rw->read_sema, 0);
+  sema_init(&rw->drain_sema, 0);
+  rw->draining = false;
+}
+
+/* Returns true if a reader arriving now must wait: a writer holds
+   RW, or one is waiting for it (writer preference). */
+static bool rwlock_readers_blocked(const struct rwlock *rw) {
+  return rw->write_lock.holder != NULL || rw->waiting_writers > 0;
+}
+
+/* Acquires RW for reading, sleeping while a writer holds or waits
+   for it.  While asleep, the current thread donates its priority
+   to the writer.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rwlock_acquire_read(struct rwlock *rw) {
+  ASSERT(rw != NULL);
+  ASSERT(!intr_context());
+  ASSERT(!rwlock_held_by_current_thread(rw));
+
+  enum intr_level old_level = intr_disable();
+  while (rwlock_readers_blocked(rw)) {
+    rw->waiting_readers++;
+    donor_enter(&rw->write_lock);  // 현재 writer에게 우선순위 기부
+    sema_down(&rw->read_sema);     // rwlock_release_write가 깨워줌 (waiting_readers도 그쪽에서 감소)
+    donor_leave(&rw->write_lock);
+  }
+  rw->readers++;
+  intr_set_level(old_level);
+}
+
+/* Acquires RW for reading if that is possible without sleeping.
+   Returns true if successful, false otherwise. */
+bool rwlock_try_acquire_read(struct rwlock *rw) {
+  bool success = false;
+
+  ASSERT(rw != NULL);
+
+  enum intr_level old_level = intr_disable();
+  if (!rwlock_readers_blocked(rw)) {
+    rw->readers++;
+    success = true;
+  }
+  intr_set_level(old_level);
+  return success;
+}
+
+/* Releases RW, which the current thread must hold for reading.
+   The last reader out lets a draining writer proceed. */
+void rwlock_release_read(struct rwlock *rw) {
+  ASSERT(rw != NULL);
+
+  enum intr_level old_level = intr_disable();
+  ASSERT(rw->readers > 0);
+  if (--rw->readers == 0 && rw->draining) {
+    rw->draining = false;
+    sema_up(&rw->drain_sema);
+  }
+  intr_set_level(old_level);
+}
+
+/* Acquires RW for writing.  Writers queue on WRITE_LOCK, in
+   priority order and with donation; the winner then waits for the
+   remaining readers to leave.  New readers are held back from the
+   moment this is called.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rwlock_acquire_write(struct rwlock *rw) {
+  ASSERT(rw != NULL);
+  ASSERT(!intr_context());
+
+  enum intr_level old_level = intr_disable();
+  rw->waiting_writers++;
+  lock_acquire(&rw->write_lock);
+  rw->waiting_writers--;
+  while (rw->readers > 0) {  // 이미 들어와 있는 reader들이 빠질 때까지 대기
+    rw->draining = true;
+    sema_down(&rw->drain_sema);
+  }
+  intr_set_level(old_level);
+}
+
+/* Acquires RW for writing if that is possible without sleeping.
+   Returns true if successful, false otherwise. */
+bool rwlock_try_acquire_write(struct rwlock *rw) {
+  bool success = false;
+
+  ASSERT(rw != NULL);
+
+  enum intr_level old_level = intr_disable();
+  if (rw->readers == 0) success = lock_try_acquire(&rw->write_lock);
+  intr_set_level(old_level);
+  return success;
+}
+
+/* Releases RW, which the current thread must hold for writing.
+   The next waiting writer, if any, goes first; otherwise every
+   waiting reader is woken. */
+void rwlock_release_write(struct rwlock *rw) {
+  ASSERT(rw != NULL);
+  ASSERT(rwlock_held_by_current_thread(rw));
+
+  enum intr_level old_level = intr_disable();
+  lock_release(&rw->write_lock);
+  if (rw->waiting_writers == 0) {
+    while (rw->waiting_readers > 0) {
+      rw->waiting_readers--;
+      sema_up(&rw->read_sema);
+    }
+  }
+  intr_set_level(old_level);
+}
+
+/* Returns true if the current thread holds RW for writing.  As
+   with locks, readers are not tracked, so there is no way to ask
+   whether the current thread holds RW for reading. */
+bool rwlock_held_by_current_thread(const struct rwlock *rw) {
+  ASSERT(rw != NULL);
+
+  return lock_held_by_current_thread(&rw->write_lock);
+}
+
+/* Initializes spinlock LOCK as free. */
+void spinlock_init(struct spinlock *lock) {
+  ASSERT(lock != NULL);
+
+  lock->locked = 0;
+}
+
+/* Acquires LOCK, spinning until it is free.  Interrupts must be
+   off, so that the holder cannot be preempted while other CPUs
+   spin on the lock.  Spinlocks are not recursive.
+
+   Unlike lock_acquire(), this may be called from inside the
+   scheduler, while the running thread is not THREAD_RUNNING, so
+   it does not record or check an owner. */
+void spinlock_acquire(struct spinlock *lock) {
+  unsigned busy;
+
+  ASSERT(lock != NULL);
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  for (;;) {
+    busy = 1;
+    asm volatile("xchgl %0, %1" : "+r"(busy), "+m"(lock->locked) : : "memory");
+    if (!busy) break;
+    while (lock->locked) asm volatile("pause");  // 읽기만 하면서 대기
+  }
+}
+
+/* Releases LOCK, which must be held. */
+void spinlock_release(struct spinlock *lock) {
+  ASSERT(lock != NULL);
+  ASSERT(lock->locked);
+
+  barrier();
+  lock->locked = 0;
 }
@@ -9,9 +9,11 @@
 #include "intrinsic.h"
 #include "threads/fixed-point.h"
 #include "threads/flags.h"
+#include "threads/fpu.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
+#include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 
@@ -28,18 +30,46 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-static struct list sleep_list;  // sleep_list를 관리할 이중 연결리스트 생성
-static struct list all_list;    // 모든 스레드를 관리함
-
-/* MLQFS 전용 다중 큐*/
-static struct list mlfqs_ready_queues[PRI_MAX - PRI_MIN + 1];
-static int ready_threads_count;
+/* Per-CPU scheduler state.
+
+   Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running, sit in the run queues of
+   some CPU.  One FIFO queue per priority; bit P of ready_mask is
+   set iff ready_queues[P] is nonempty, so the highest ready
+   priority is a single bsr away.  Both the priority scheduler and
+   mlfqs use these queues; the fair scheduler keeps its ready
+   threads in fair_queue instead (see below).  Threads in the EDF
+   class sit in dl_queue, which is served before any of the others.
+
+   This is groundwork for SMP, not SMP support: only the bootstrap
+   processor runs, so cpu_cnt is 1 and this_cpu() is always the
+   BSP.  Splitting the state out and guarding it with rq_lock keeps
+   the single-CPU scheduler unchanged while giving each future CPU
+   its own queues.  Still missing before a second CPU can run:
+   LAPIC/IOAPIC setup and AP startup from init.c, per-CPU GDT, TSS
+   and stacks, spinlocks in place of intr_disable() in synch.c, and
+   moving threads between the CPUs' queues. */
+#define PRI_CNT (PRI_MAX - PRI_MIN + 1)
+struct cpu {
+  struct spinlock rq_lock;           /* Protects the run queue fields below. */
+  struct list ready_queues[PRI_CNT]; /* Run queues, one per priority. */
+  uint64_t ready_mask;               /* Bit P set iff ready_queues[P] nonempty. */
+  int ready_threads_count;           /* # of non-idle threads in the queues. */
+  struct heap dl_queue;              /* EDF threads, earliest deadline on top. */
+  struct rbtree fair_queue;          /* -o fair: ready threads by vruntime. */
+  uint64_t fair_load;                /* Sum of fair_queue's nice weights. */
+  uint64_t min_vruntime;             /* Monotonic floor of vruntimes on this CPU. */
+  struct thread *idle_thread;        /* This CPU's idle thread. */
+  unsigned thread_ticks;             /* # of timer ticks since last yield. */
+  int64_t rq_epoch;                  /* mlfqs decay epoch the queues are settled to. */
+};
+static struct cpu cpus[CPU_MAX];
+static int cpu_cnt;
+
+/* Returns the CPU we are running on. */
+#define this_cpu() (&cpus[0])
 
-/* Idle thread. */
-static struct thread *idle_thread;
+static struct list all_list;    // 모든 스레드를 관리함
 
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
@@ -58,15 +88,93 @@ static long long user_ticks;   /* # of timer ticks in user programs. */
 /* mlfqs global variables */
 static fixed_t load_avg; /* 시스템 부하 평균 (fixed-point) */
 
+/* recent_cpu is decayed lazily.  Each second starts a new epoch
+   and records that second's decay coefficient
+   2*load_avg / (2*load_avg + 1) in decay_history; a thread's
+   pending decays are applied by mlfqs_settle() only when the
+   thread is next examined or enqueued.  Ready threads are settled
+   and moved to their new queues all at once by the first pick of
+   each epoch, and the waiters of a semaphore or condition variable
+   by its first wake-up of each epoch (see synch.c), so picks and
+   wake-ups see the same priorities eager decay would give.
+
+   This is not free.  The first pick of each second walks every
+   ready thread with interrupts off, so scheduling latency still
+   grows with the run queue once a second; the per-tick work is
+   what stays constant.  Likewise for the first wake-up on a busy
+   wait heap.  And only DECAY_HISTORY coefficients are kept: a
+   thread blocked for longer than that has its oldest missed
+   seconds decayed with the oldest recorded coefficient, so its
+   recent_cpu is approximate, although it converges the same way
+   since every coefficient is below 1. */
+#define DECAY_HISTORY 16
+static int64_t decay_epoch;                   /* 지금까지 지난 초(epoch) 수 */
+static fixed_t decay_history[DECAY_HISTORY]; /* epoch E의 감쇠 계수는 [E % DECAY_HISTORY] */
+
 /* Scheduling. */
 #define TIME_SLICE 4          /* # of timer ticks to give each thread. */
-static unsigned thread_ticks; /* # of timer ticks since last yield. */
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* Fair-share scheduling ("-o fair").
+
+   Each thread accumulates vruntime, the TSC cycles it has run
+   scaled by NICE_0_WEIGHT / its weight, so a thread of weight W
+   ages W / NICE_0_WEIGHT times as slowly as a nice-0 thread.  The
+   ready thread with the least vruntime runs next.  Weights are
+   Linux's: each nice step is worth about 10% of CPU.
+
+   Instead of a fixed TIME_SLICE, every ready thread should run
+   once per FAIR_LATENCY ticks, each for a share of that period
+   proportional to its weight but never less than
+   FAIR_MIN_GRANULARITY.  A woken thread preempts the running one
+   only if it is behind by more than FAIR_WAKEUP_GRANULARITY, and
+   a sleeper re-enters no further than half a period behind
+   min_vruntime, so long sleeps do not buy unbounded CPU. */
+bool thread_fair;
+
+#define NICE_0_WEIGHT 1024
+#define FAIR_LATENCY 8            /* Ticks in which every ready thread runs. */
+#define FAIR_MIN_GRANULARITY 1    /* Ticks a thread runs before preemption. */
+#define FAIR_WAKEUP_GRANULARITY 1 /* Ticks a woken thread must be behind. */
+#define FAIR_TSC_PER_TICK 10000000 /* Until timer_calibrate() measures it. */
+
+static const uint32_t nice_weights[NICE_MAX - NICE_MIN + 1] = {
+    /* -20 */ 88761, 71755, 56483, 46273, 36291,
+    /* -15 */ 29154, 23254, 18705, 14949, 11916,
+    /* -10 */ 9548,  7620,  6100,  4904,  3906,
+    /*  -5 */ 3121,  2501,  1991,  1586,  1277,
+    /*   0 */ 1024,  820,   655,   526,   423,
+    /*   5 */ 335,   272,   215,   172,   137,
+    /*  10 */ 110,   87,    70,    56,    45,
+    /*  15 */ 36,    29,    23,    18,    15,
+    /*  20 */ 12,
+};
+
+/* Earliest-deadline-first class (thread_set_deadline()).
+
+   An EDF thread is promised RUNTIME ticks of CPU in every PERIOD
+   ticks and runs ahead of every priority, mlfqs or fair thread;
+   among EDF threads the earliest absolute deadline wins.
+   thread_tick() charges the running EDF thread's budget; once it
+   is spent before the deadline the thread is throttled, blocked
+   until a timer at the deadline refills the budget and starts the
+   next period.  A thread that wakes with more budget than it could
+   use at its reserved rate before its deadline starts a fresh
+   period instead (the constant bandwidth server rule), so sleeping
+   cannot bank CPU time.
+
+   Admission control keeps the sum of runtime / period over all EDF
+   threads at or below DL_BW_LIMIT per CPU, which leaves every
+   admitted thread its full budget before its deadline. */
+#define DL_BW_SHIFT 20                                 /* Fraction bits of dl_bw. */
+#define DL_BW_LIMIT ((95ULL << DL_BW_SHIFT) / 100)    /* 95% of one CPU. */
+#define PRI_DL (PRI_MAX + 1)                           /* rq_max_priority() for EDF. */
+static uint64_t dl_total_bw; /* Sum of dl_bw over all EDF threads. */
+
 static void kernel_thread(thread_func *, void *aux);
 
 static void idle(void *aux UNUSED);
@@ -75,7 +183,31 @@ static void init_thread(struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule(void);
 static tid_t allocate_tid(void);
-static void thread_update_recent_cpu(struct thread *t);
+static fixed_t decay_recent_cpu(fixed_t recent_cpu, fixed_t coeff, int nice, int64_t n);
+static bool is_idle(const struct thread *t);
+static int rq_max_priority(const struct cpu *c);
+static void rq_push(struct cpu *c, struct thread *t);
+static void rq_remove(struct cpu *c, struct thread *t);
+static struct thread *rq_pop(struct cpu *c);
+static void ready_queue_push(struct thread *t);
+static void ready_queue_remove(struct thread *t);
+static void thread_rekey_priority(struct thread *t, int priority);
+static void rq_resettle(struct cpu *c);
+static bool rq_empty(const struct cpu *c);
+static bool rq_preempts(const struct cpu *c, const struct thread *curr);
+static bool dl_before(const struct thread *a, const struct thread *b);
+static bool dl_tick(struct thread *t);
+static void dl_wakeup(struct thread *t);
+static void dl_replenish(void *t_);
+static bool dl_less(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED);
+static bool thread_should_preempt(struct thread *t);
+static uint64_t fair_cycles(int64_t ticks);
+static uint64_t fair_weight(const struct thread *t);
+static uint64_t fair_slice(const struct cpu *c, const struct thread *t);
+static void fair_update_curr(struct cpu *c, struct thread *t);
+static bool fair_tick(struct cpu *c, struct thread *t);
+static bool fair_less(const struct rb_node *a, const struct rb_node *b, void *aux UNUSED);
+static bool held_lock_less(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED);
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -116,31 +248,39 @@ void thread_init(void) {
 
   /* Init the global thread context */
   lock_init(&tid_lock);
-  list_init(&ready_list);
-  list_init(&sleep_list);
+  cpu_cnt = 1;
+  for (int c = 0; c < cpu_cnt; c++) {
+    spinlock_init(&cpus[c].rq_lock);
+    for (int i = 0; i < PRI_CNT; i++) list_init(&cpus[c].ready_queues[i]);
+    cpus[c].ready_mask = 0;
+    cpus[c].ready_threads_count = 0;
+    heap_init(&cpus[c].dl_queue, dl_less, NULL);
+    rbtree_init(&cpus[c].fair_queue, fair_less, NULL);
+    cpus[c].fair_load = 0;
+    cpus[c].min_vruntime = 0;
+    cpus[c].idle_thread = NULL;
+    cpus[c].thread_ticks = 0;
+  }
   list_init(&all_list);
   list_init(&destruction_req);
 
   /* mlfqs 초기화 */
   load_avg = INT_TO_FP(0); /* load_avg 를 0.0으로 초기화 */
+  decay_epoch = 0;
 
   /* Set up a thread structure for the running thread. */
   initial_thread = running_thread();
   init_thread(initial_thread, "main", PRI_DEFAULT);
   initial_thread->status = THREAD_RUNNING;  // 이거 순서 매우 중요함
   initial_thread->tid = allocate_tid();
+  initial_thread->acct_stamp = initial_thread->fair_stamp = rdtsc();
   list_push_front(&all_list, &initial_thread->all_elem);
 
-  if (thread_mlfqs) {
+  if (thread_mlfqs)
     mlfqs_update_priority(initial_thread);  // 첫 main쓰레드 priority 설정(PRI_MAX)
-
-    // mlfqs_ready_queues에는 PRI_MIN을 시작으로 PRI_MAX까지 우선순위별 다중 큐임
-    for (int i = PRI_MIN; i <= PRI_MAX; i++) {
-      list_init(&mlfqs_ready_queues[i - PRI_MIN]);
-    }
-    ready_threads_count = 0;  // 0으로 초기화
-
-  } else
+  else if (thread_fair)
+    printf("Fair-share scheduler enabled\n");
+  else
     printf("Priority scheduler enabled\n");
 }
 
@@ -155,7 +295,7 @@ void thread_start(void) {
   /* Start preemptive thread scheduling. */
   intr_enable();
 
-  /* Wait for the idle thread to initialize idle_thread. */
+  /* Wait for the idle thread to initialize this_cpu()->idle_thread. */
   sema_down(&idle_started);
 }
 
@@ -165,7 +305,7 @@ void thread_tick(void) {
   struct thread *t = thread_current();
 
   /* Update statistics. */
-  if (t == idle_thread) idle_ticks++;
+  if (is_idle(t)) idle_ticks++;
 #ifdef USERPROG
   else if (t->pml4 != NULL)
     user_ticks++;
@@ -174,7 +314,12 @@ void thread_tick(void) {
     kernel_ticks++;
 
   /* Enforce preemption. */
-  if (++thread_ticks >= TIME_SLICE) intr_yield_on_return();
+  if (t->dl_period != 0) {  // EDF 쓰레드는 타임 슬라이스 대신 예산으로 제한
+    if (dl_tick(t)) intr_yield_on_return();
+  } else if (thread_fair) {
+    if (!is_idle(t) && fair_tick(this_cpu(), t)) intr_yield_on_return();
+  } else if (++this_cpu()->thread_ticks >= TIME_SLICE)
+    intr_yield_on_return();
 }
 
 /* Prints thread statistics. */
@@ -204,7 +349,7 @@ tid_t thread_create(const char *name, int priority, thread_func *function, void
   ASSERT(function != NULL);
 
   /* Allocate thread. */
-  t = palloc_get_page(PAL_ZERO);
+  t = palloc_get_page(PAL_ZERO | PAL_TAG(MEM_THREAD));
   if (t == NULL) return TID_ERROR;
 
   /* Initialize thread. */
@@ -216,22 +361,27 @@ tid_t thread_create(const char *name, int priority, thread_func *function, void
     struct thread *parent = thread_current();
     // 부모 쓰레드의 nice, recent_cpu 물려받기
     if (parent != NULL) {
+      mlfqs_settle(parent);  // 부모의 밀린 감쇠부터 반영
       t->nice = parent->nice;
       t->recent_cpu = parent->recent_cpu;
     }
     mlfqs_update_priority(t);  // priority 공식으로 계산
+  } else if (thread_fair) {
+    // nice는 물려받고, vruntime은 지금 CPU의 최솟값에서 출발
+    t->nice = thread_current()->nice;
+    t->vruntime = this_cpu()->min_vruntime;
   }
 
-  /* Call the kernel_thread if it scheduled.
-   * Note) rdi is 1st argument, and rsi is 2nd argument. */
-  t->tf.rip = (uintptr_t)kernel_thread;
-  t->tf.R.rdi = (uint64_t)function;
-  t->tf.R.rsi = (uint64_t)aux;
-  t->tf.ds = SEL_KDSEG;
-  t->tf.es = SEL_KDSEG;
-  t->tf.ss = SEL_KDSEG;
-  t->tf.cs = SEL_KCSEG;
-  t->tf.eflags = FLAG_IF;
+  /* Build the frame switch_threads() will pop the first time T is
+   * scheduled: its `ret' lands in switch_entry, which calls
+   * kernel_thread (FUNCTION, AUX).  Leave 16 bytes above the frame
+   * so that the call happens with a 16-byte aligned stack. */
+  struct switch_threads_frame *sf = (struct switch_threads_frame *)((uint8_t *)t + PGSIZE - 16) - 1;
+  sf->rip = switch_entry;
+  sf->r12 = (uint64_t)function;
+  sf->r13 = (uint64_t)aux;
+  sf->r14 = (uint64_t)kernel_thread;
+  t->switch_rsp = (uint64_t)sf;
 
   /* Add to run queue. */
   thread_unblock(t);
@@ -269,21 +419,17 @@ void thread_unblock(struct thread *t) {
                                         // 반환(기존 상태 저장해놓고, disable 만듬)
   ASSERT(t->status == THREAD_BLOCKED);  // 해당 쓰레드의 status 필드가 THREAD_BLOCKED인지 확인
 
-  if (thread_mlfqs) {
-    list_push_back(&mlfqs_ready_queues[t->priority - PRI_MIN], &t->elem);  // 우선순위에 맞는 큐에 집어넣음
-    if (t != idle_thread)  // idle thread는 카운트 하면 안되므로
-      ready_threads_count++;
-  } else {
-    list_insert_ordered(&ready_list, &t->elem, thread_priority_less, NULL);  // 우선순위 큰 순서대로 삽입
-  }
+  if (t->dl_period != 0) dl_wakeup(t);  // 남은 예산으로 마감까지 버틸 수 없으면 새 주기 시작
+
+  ready_queue_push(t);       // 우선순위에 맞는 큐의 끝에 삽입
   t->status = THREAD_READY;  // 해당 쓰레드의 상태를 THREAD_READY로 바꿈
 
   // 인터럽트끝나고 보내야할 경우에
-  if (t->priority > thread_current()->priority) {
+  if (thread_should_preempt(t)) {
     if (intr_context()) {
       // 인터럽트 핸들러 내부: 나중에 yield
       intr_yield_on_return();
-    } else if (thread_current() != idle_thread) {  // idle은 yield하지 않도록
+    } else if (!is_idle(thread_current())) {  // idle은 yield하지 않도록
       // 일반 컨텍스트: 플래그 설정
       intr_set_level(old_level);
       thread_yield();
@@ -316,6 +462,10 @@ struct thread *thread_current(void) {
 /* Returns the running thread's tid. */
 tid_t thread_tid(void) { return thread_current()->tid; }
 
+/* Returns the number of the CPU we are running on.  The answer
+   only stays true while interrupts are off. */
+int thread_cpu(void) { return this_cpu() - cpus; }
+
 /* Deschedules the current thread and destroys it.  Never
    returns to the caller. */
 void thread_exit(void) {
@@ -329,6 +479,7 @@ void thread_exit(void) {
      We will be destroyed during the call to schedule_tail(). */
   intr_disable();
   list_remove(&thread_current()->all_elem);  // all_list에서 제거
+  dl_total_bw -= thread_current()->dl_bw;    // EDF 대역폭 반납
   do_schedule(THREAD_DYING);
   NOT_REACHED();
 }
@@ -341,29 +492,18 @@ void thread_yield(void) {  // 현재 스레드가 가장 높은 우선순위를
   ASSERT(!intr_context());
 
   enum intr_level old_level = intr_disable();
-  if (curr != idle_thread) {
-    if (thread_mlfqs) {  // mlfqs 모드인 경우
-      int max_priority = max_priority_mlfqs_queue();
-      if (max_priority >= 0) {  // 전체 큐가 비어있지 않은 경우
-        if (curr->priority > max_priority) {
-          intr_set_level(old_level);
-          return;
-        }
-      }
-      list_push_back(&mlfqs_ready_queues[curr->priority - PRI_MIN],
-                     &curr->elem);  // 본인 우선순위에 맞는 레디큐로 들어감
-      ready_threads_count++;
-    } else {
-      if (!list_empty(&ready_list)) {
-        struct thread *highest = list_entry(list_front(&ready_list), struct thread, elem);
-
-        if (curr->priority > highest->priority) {  // 현재 쓰레드가 ready_list에 있는 쓰레드들보다 우선순위가 높다면
-          intr_set_level(old_level);
-          return;  // yield를 할 필요가 없음.
-        }
-      }
-      list_insert_ordered(&ready_list, &curr->elem, thread_priority_less, NULL);  // 우선순위 순으로 정렬하며 삽입
+  if (curr->dl_throttled) {  // 예산을 다 쓴 EDF 쓰레드는 dl_replenish()가 깨울 때까지 잠듦
+    do_schedule(THREAD_BLOCKED);
+    intr_set_level(old_level);
+    return;
+  }
+  if (!is_idle(curr)) {
+    // 현재 쓰레드보다 먼저 돌아야 할 쓰레드가 레디큐에 없다면 yield를 할 필요가 없음.
+    if (!rq_preempts(this_cpu(), curr)) {
+      intr_set_level(old_level);
+      return;
     }
+    ready_queue_push(curr);  // 본인 우선순위에 맞는 레디큐의 끝으로 들어감
   }
   do_schedule(THREAD_READY);
   intr_set_level(old_level);
@@ -376,51 +516,15 @@ void thread_set_priority(int new_priority) {
   struct thread *curr = thread_current();
   int old_priority = curr->priority;
 
-  // donate를 안받은 경우에는 priority를 바꿔주어야 함. // lock_release에서 적당한 priority로 바꿔 줄거라서
-  if (curr->is_donated == 0) curr->priority = new_priority;
+  // 기부받은 우선순위가 더 높다면 그대로 유지됨
+  enum intr_level old_level = intr_disable();
   curr->original_priority = new_priority;
-  if (old_priority > new_priority) {  // 만약 우선순위가 더 낮아졌고, ready_list에 원소가 있을 떄
+  curr->priority = thread_effective_priority(curr);
+  intr_set_level(old_level);
+  if (old_priority > curr->priority) {  // 만약 우선순위가 더 낮아졌고, ready_list에 원소가 있을 떄
     thread_yield();                   // yield를 통해 뒤로 보냄
   }
 }
-// thread_update_all_priority 생성해야함
-void thread_update_all_priority(void) {
-  enum intr_level old_level = intr_disable();  // 인터럽트 끄기
-  struct list_elem *e;                         // all_list 순회 시 사용하는 iterator
-  struct list new_ready_queue;                 // ready 큐 임시 저장(싹다 뺐다가 싹다 넣을 거임)
-  list_init(&new_ready_queue);                 // new_ready 큐 초기화
-
-  /* all list 순회하며 priority 갱신 */
-  for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
-    struct thread *t = list_entry(e, struct thread, all_elem);
-    if (t == idle_thread) continue;                // idle 쓰레드는 제외
-    if (t->status == THREAD_READY) {               // ready queue에 있던 thread라면
-      list_remove(&t->elem);                       // 기존에 있던 ready queue에서 빼고
-      list_push_back(&new_ready_queue, &t->elem);  //임시 저장 큐에 집어넣기
-    }
-    mlfqs_update_priority(t);  // priority 조정
-  }
-
-  // ready 큐들은 다시 다중 큐에 집어 넣기
-  while (!list_empty(&new_ready_queue)) {
-    e = list_pop_front(&new_ready_queue);
-    struct thread *t = list_entry(e, struct thread, elem);
-    list_push_back(&mlfqs_ready_queues[t->priority - PRI_MIN], e);
-  }
-
-  // 혹시 현재 스레드의 우선순위가 레디큐에 있는 쓰레드보다 작거나 같다면 양보해야함
-  if (thread_current()->priority < max_priority_mlfqs_queue()) {
-    if (intr_context()) {
-      intr_yield_on_return();
-    } else {
-      intr_set_level(old_level);  // 인터럽트 풀어주고
-      thread_yield();             // 양보
-      return;
-    }
-  }
-
-  intr_set_level(old_level);  // 인터럽트 복원
-}
 void mlfqs_update_priority(struct thread *t) {
   if (!thread_mlfqs) return;  // mlqfs 가 아니라면 나가라
 
@@ -439,7 +543,9 @@ void mlfqs_update_priority(struct thread *t) {
   if (new_priority > PRI_MAX) new_priority = PRI_MAX;  // max를 넘어갔으면 max로
   if (new_priority < PRI_MIN) new_priority = PRI_MIN;  // min을 넘어갔으면 min으로
 
-  t->priority = new_priority;
+  // 런 큐는 건드리지 않는다. rq_push/rq_pop이 rq_lock을 쥔 채 settle하며 여기로 오고,
+  // 큐 안의 자리는 그 호출자가 정한다. cond_wait 도중이면 대기 힙만 재정렬
+  thread_rekey_priority(t, new_priority);
 }
 
 /* Returns the current thread's priority. */
@@ -456,13 +562,15 @@ void thread_set_nice(int nice) {
   enum intr_level old_level = intr_disable();
   //현재 스레드의 nice 값 업데이트
   struct thread *curr = thread_current();
+  mlfqs_settle(curr);  // 이전 nice 기준으로 밀린 감쇠를 먼저 반영
+  if (thread_fair) fair_update_curr(this_cpu(), curr);  // 지금까지 실행한 시간은 이전 가중치로 정산
   curr->nice = nice;
   // 자신의 priority 재계산
   mlfqs_update_priority(curr);
 
   // 만약 자신이 더 이상 최고 priority가 아니면 양보
   /* 조건보고 양보하는 경우 (다른 쓰레드에 의해서 race 발생해서 max가 바뀔수도 있음)*/
-  if (curr->priority < max_priority_mlfqs_queue()) {
+  if (curr->priority < thread_ready_max_priority()) {
     if (intr_context()) {
       intr_yield_on_return();
     } else {
@@ -474,6 +582,44 @@ void thread_set_nice(int nice) {
   intr_set_level(old_level);
 }
 
+/* Moves the current thread into the EDF class, promising it
+   RUNTIME timer ticks of CPU time in every PERIOD ticks, with the
+   first period starting now.  If PERIOD and RUNTIME are both 0,
+   the thread returns to its normal scheduling class instead.
+
+   Returns false, changing nothing, if 0 < RUNTIME <= PERIOD does
+   not hold, or if admitting the thread would push the total EDF
+   utilization above what the CPUs can guarantee. */
+bool thread_set_deadline(int64_t period, int64_t runtime) {
+  struct thread *curr = thread_current();
+  uint64_t bw = 0;
+
+  if (period != 0 || runtime != 0) {
+    if (runtime <= 0 || runtime > period) return false;
+    bw = ((uint64_t)runtime << DL_BW_SHIFT) / period;
+  }
+
+  enum intr_level old_level = intr_disable();
+  if (dl_total_bw - curr->dl_bw + bw > DL_BW_LIMIT * cpu_cnt) {  // 승인 제어
+    intr_set_level(old_level);
+    return false;
+  }
+  dl_total_bw = dl_total_bw - curr->dl_bw + bw;
+  curr->dl_bw = bw;
+  curr->dl_period = period;
+  curr->dl_runtime = runtime;
+  curr->dl_deadline = timer_ticks() + period;
+  curr->dl_budget = runtime;
+  if (period == 0 && thread_fair) {  // fair 클래스로 돌아가면 지금 CPU의 최솟값에서 다시 출발
+    curr->vruntime = this_cpu()->min_vruntime;
+    curr->fair_stamp = rdtsc();
+  }
+  intr_set_level(old_level);
+
+  thread_yield();  // 더 급한 쓰레드가 있다면 양보
+  return true;
+}
+
 /* Returns the current thread's nice value. */
 int thread_get_nice(void) { return thread_current()->nice; }
 
@@ -481,35 +627,88 @@ int thread_get_nice(void) { return thread_current()->nice; }
 int thread_get_load_avg(void) { return FP_TO_INT_ZERO(MULT_FP_INT(load_avg, 100)); }
 // timer_interrupt 함수에서 구현했으면 getter함수때문에 가독성이 떨어질까봐 접근이 쉬운 thread.c에서 구현
 void thread_update_load_avg(void) {
-  int running_and_ready_thread_count =
-      ready_threads_count + is_not_idle(thread_current());  // 현재 스레드도 갯수에 포함해야 하는데, idle은 포함 x
+  int running_and_ready_thread_count = is_not_idle(thread_current());  // 현재 스레드도 포함해야 하는데, idle은 포함 x
+  for (int c = 0; c < cpu_cnt; c++) running_and_ready_thread_count += cpus[c].ready_threads_count;
   // load_avg = (59/60) * load_avg + (1/60) * ready_threads_count;
   load_avg = ADD_FP(MULT_FP(FP_59_60, load_avg), MULT_FP_INT(FP_1_60, running_and_ready_thread_count));
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
-int thread_get_recent_cpu(void) { return FP_TO_INT_ZERO(MULT_FP_INT(thread_current()->recent_cpu, 100)); }
-void thread_update_all_recent_cpu(void) {
-  struct list_elem *e;  // thread_list 순회 시 사용하는 iterator
-
-  /* all list 순회하며 recent_cpu 갱신 */
-  for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
-    struct thread *t = list_entry(e, struct thread, all_elem);
-    if (t != idle_thread) thread_update_recent_cpu(t);
+int thread_get_recent_cpu(void) {
+  enum intr_level old_level = intr_disable();
+  struct thread *curr = thread_current();
+
+  mlfqs_settle(curr);
+  intr_set_level(old_level);
+  return FP_TO_INT_ZERO(MULT_FP_INT(curr->recent_cpu, 100));
+}
+
+/* Starts a new recent_cpu decay epoch, using the load_avg that
+   thread_update_load_avg() just computed.  Called once per second
+   from the timer interrupt; takes constant time no matter how
+   many threads exist. */
+void thread_decay_recent_cpu(void) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  /* recent_cpu = load_avg * 2 / (load_avg * 2 + 1) * recent_cpu  + nice */
+  decay_epoch++;
+  decay_history[decay_epoch % DECAY_HISTORY] =
+      DIV_FP(MULT_FP_INT(load_avg, 2), ADD_FP_INT(MULT_FP_INT(load_avg, 2), 1));
+}
+
+/* Returns the current recent_cpu decay epoch, for callers that
+   settle threads lazily themselves. */
+int64_t thread_decay_epoch(void) {
+  return decay_epoch;
+}
+
+/* Applies every recent_cpu decay that T has missed since it was
+   last settled, then recomputes T's mlfqs priority.  Does not move
+   T between run queues.  Interrupts must be off. */
+void mlfqs_settle(struct thread *t) {
+  int64_t behind = decay_epoch - t->decay_epoch;
+
+  if (!thread_mlfqs || behind == 0) return;
+  t->decay_epoch = decay_epoch;
+  if (is_idle(t)) return;  // idle 쓰레드는 제외
+
+  int64_t e = decay_epoch - behind + 1;  // 처음으로 놓친 epoch
+  if (behind > DECAY_HISTORY) {
+    // 기록이 남아있지 않은 오래된 epoch들은 가장 오래된 계수로 근사
+    e = decay_epoch - DECAY_HISTORY + 1;
+    t->recent_cpu =
+        decay_recent_cpu(t->recent_cpu, decay_history[e % DECAY_HISTORY], t->nice, behind - DECAY_HISTORY);
   }
+  for (; e <= decay_epoch; e++)
+    t->recent_cpu = decay_recent_cpu(t->recent_cpu, decay_history[e % DECAY_HISTORY], t->nice, 1);
+  mlfqs_update_priority(t);
 }
-// 각 리스트 별로 매크로 떡칠인 라인을 넣자니 너무 지저분해서 따로 함수로 만듬
-/* recent_cpu = load_avg * 2 / (load_avg * 2 + 1) * recent_cpu  + nice */
-static void thread_update_recent_cpu(struct thread *t) {
-  t->recent_cpu = ADD_FP_INT(
-      MULT_FP(DIV_FP(MULT_FP_INT(load_avg, 2), ADD_FP_INT(MULT_FP_INT(load_avg, 2), 1)), t->recent_cpu), t->nice);
+
+/* Applies recent_cpu = COEFF * recent_cpu + NICE to RECENT_CPU N
+   times in closed form:
+   COEFF^N * recent_cpu + NICE * (1 - COEFF^N) / (1 - COEFF).
+   COEFF = 2*load_avg / (2*load_avg + 1) is always below 1, since
+   load_avg is never negative. */
+static fixed_t decay_recent_cpu(fixed_t recent_cpu, fixed_t coeff, int nice, int64_t n) {
+  fixed_t coeff_n = INT_TO_FP(1), base = coeff;
+  fixed_t geo_sum;
+
+  ASSERT(coeff < INT_TO_FP(1));
+  if (n == 1) return ADD_FP_INT(MULT_FP(coeff, recent_cpu), nice);
+
+  for (int64_t k = n; k > 0; k >>= 1) {  // 거듭제곱을 제곱해가며 계산
+    if (k & 1) coeff_n = MULT_FP(coeff_n, base);
+    base = MULT_FP(base, base);
+  }
+  geo_sum = DIV_FP(SUB_FP(INT_TO_FP(1), coeff_n), SUB_FP(INT_TO_FP(1), coeff));
+  return ADD_FP(MULT_FP(coeff_n, recent_cpu), MULT_FP_INT(geo_sum, nice));
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
 
    The idle thread is initially put on the ready list by
    thread_start().  It will be scheduled once initially, at which
-   point it initializes idle_thread, "up"s the semaphore passed
+   point it initializes its CPU's idle_thread, "up"s the semaphore passed
    to it to enable thread_start() to continue, and immediately
    blocks.  After that, the idle thread never appears in the
    ready list.  It is returned by next_thread_to_run() as a
@@ -517,7 +716,7 @@ static void thread_update_recent_cpu(struct thread *t) {
 static void idle(void *idle_started_ UNUSED) {
   struct semaphore *idle_started = idle_started_;
 
-  idle_thread = thread_current();
+  this_cpu()->idle_thread = thread_current();
   sema_up(idle_started);
 
   for (;;) {
@@ -536,7 +735,11 @@ static void idle(void *idle_started_ UNUSED) {
        time.
 
        See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
-       7.11.1 "HLT Instruction". */
+       7.11.1 "HLT Instruction".
+
+       In tickless mode, first trade the periodic tick for a
+       one-shot at the next pending timer. */
+    timer_idle_enter();
     asm volatile("sti; hlt" : : : "memory");
   }
 }
@@ -564,20 +767,18 @@ static void init_thread(struct thread *t, const char *name, int priority) {
   memset(t, 0, sizeof *t);
   t->status = THREAD_BLOCKED;
   strlcpy(t->name, name, sizeof t->name);
-  t->tf.rsp = (uint64_t)t + PGSIZE - sizeof(void *);
   t->magic = THREAD_MAGIC;
 
-  t->wake_tick = 0;  // 깨워야하는 시간 초기화
-
   t->priority = priority;
   t->original_priority = priority;
-  list_init(&t->acquired_locks);
+  t->acct_mode = ACCT_SYS;  // 커널에서 시작, 유저로 넘어갈 때 process.c에서 전환
+  heap_init(&t->held_locks, held_lock_less, NULL);
   t->waiting_for_lock = NULL;
-  t->is_donated = 0;
 
   /* mlfqs 멤버 초기화 */
   t->nice = 0;
   t->recent_cpu = INT_TO_FP(0);
+  t->decay_epoch = decay_epoch;
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
@@ -586,21 +787,16 @@ static void init_thread(struct thread *t, const char *name, int priority) {
    will be in the run queue.)  If the run queue is empty, return
    idle_thread. */
 static struct thread *next_thread_to_run(void) {
-  if (thread_mlfqs) {  // mlfqs 일 때
-    int max_priority;
-    if ((max_priority = max_priority_mlfqs_queue()) >= 0) {  // ready 다중 큐에서 존재하는 가장 높은 prioirty 반환
-      ready_threads_count--;                                 // ready_thread_count를 뺌
-      struct thread *selected =
-          list_entry(list_pop_front(&mlfqs_ready_queues[max_priority - PRI_MIN]), struct thread, elem);
-      return selected;
-    } else  // 큐에 존재하는 쓰레드가 없을 때
-      return idle_thread;
-  } else {  // 일반적인 경우 일 때
-    if (list_empty(&ready_list))
-      return idle_thread;
-    else
-      return list_entry(list_pop_front(&ready_list), struct thread, elem);
-  }
+  struct cpu *c = this_cpu();
+  struct thread *next;
+
+  spinlock_acquire(&c->rq_lock);
+  if (rq_empty(c))  // 큐에 존재하는 쓰레드가 없을 때
+    next = c->idle_thread;
+  else
+    next = rq_pop(c);
+  spinlock_release(&c->rq_lock);
+  return next;
 }
 
 /* Use iretq to launch the thread */
@@ -632,73 +828,21 @@ void do_iret(struct intr_frame *tf) {
       : "memory");
 }
 
-/* Switching the thread by activating the new thread's page
-   tables, and, if the previous thread is dying, destroying it.
+/* Switches from the running thread to TH.
 
-   At this function's invocation, we just switched from thread
-   PREV, the new thread is already running, and interrupts are
-   still disabled.
+   Every switch happens inside schedule(), between two threads
+   running kernel code, so only the callee-saved registers and the
+   stack pointer need saving; switch_threads() does that and
+   returns into TH with a plain `ret'.  The full intr_frame and
+   iretq path (do_iret()) is used only to enter user mode.
 
-   It's not safe to call printf() until the thread switch is
-   complete.  In practice that means that printf()s should be
-   added at the end of the function. */
+   At this function's return, we are running again as the
+   original thread, switched back to by some later schedule(),
+   and interrupts are still disabled. */
 static void thread_launch(struct thread *th) {
-  uint64_t tf_cur = (uint64_t)&running_thread()->tf;
-  uint64_t tf = (uint64_t)&th->tf;
   ASSERT(intr_get_level() == INTR_OFF);
 
-  /* The main switching logic.
-   * We first restore the whole execution context into the intr_frame
-   * and then switching to the next thread by calling do_iret.
-   * Note that, we SHOULD NOT use any stack from here
-   * until switching is done. */
-  __asm __volatile(
-      /* Store registers that will be used. */
-      "push %%rax\n"
-      "push %%rbx\n"
-      "push %%rcx\n"
-      /* Fetch input once */
-      "movq %0, %%rax\n"
-      "movq %1, %%rcx\n"
-      "movq %%r15, 0(%%rax)\n"
-      "movq %%r14, 8(%%rax)\n"
-      "movq %%r13, 16(%%rax)\n"
-      "movq %%r12, 24(%%rax)\n"
-      "movq %%r11, 32(%%rax)\n"
-      "movq %%r10, 40(%%rax)\n"
-      "movq %%r9, 48(%%rax)\n"
-      "movq %%r8, 56(%%rax)\n"
-      "movq %%rsi, 64(%%rax)\n"
-      "movq %%rdi, 72(%%rax)\n"
-      "movq %%rbp, 80(%%rax)\n"
-      "movq %%rdx, 88(%%rax)\n"
-      "pop %%rbx\n"  // Saved rcx
-      "movq %%rbx, 96(%%rax)\n"
-      "pop %%rbx\n"  // Saved rbx
-      "movq %%rbx, 104(%%rax)\n"
-      "pop %%rbx\n"  // Saved rax
-      "movq %%rbx, 112(%%rax)\n"
-      "addq $120, %%rax\n"
-      "movw %%es, (%%rax)\n"
-      "movw %%ds, 8(%%rax)\n"
-      "addq $32, %%rax\n"
-      "call __next\n"  // read the current rip.
-      "__next:\n"
-      "pop %%rbx\n"
-      "addq $(out_iret -  __next), %%rbx\n"
-      "movq %%rbx, 0(%%rax)\n"  // rip
-      "movw %%cs, 8(%%rax)\n"   // cs
-      "pushfq\n"
-      "popq %%rbx\n"
-      "mov %%rbx, 16(%%rax)\n"  // eflags
-      "mov %%rsp, 24(%%rax)\n"  // rsp
-      "movw %%ss, 32(%%rax)\n"
-      "mov %%rcx, %%rdi\n"
-      "call do_iret\n"
-      "out_iret:\n"
-      :
-      : "g"(tf_cur), "g"(tf)
-      : "memory");
+  switch_threads(&running_thread()->switch_rsp, th->switch_rsp);
 }
 
 /* Schedules a new process. At entry, interrupts must be off.
@@ -710,6 +854,7 @@ static void do_schedule(int status) {
   ASSERT(thread_current()->status == THREAD_RUNNING);
   while (!list_empty(&destruction_req)) {
     struct thread *victim = list_entry(list_pop_front(&destruction_req), struct thread, elem);
+    fpu_release(victim);
     palloc_free_page(victim);
   }
   thread_current()->status = status;
@@ -719,6 +864,9 @@ static void do_schedule(int status) {
 static void schedule(void) {
   struct thread *curr = running_thread();      // 레지스터 rsp를 활용하여 현재 돌고
                                                // 있는 쓰레드 포인터를 찾음
+  // fair: 블록/종료하는 쓰레드의 실행 시간 정산 (yield는 트리에 넣을 때 이미 정산됨)
+  if (thread_fair && curr->status != THREAD_READY) fair_update_curr(this_cpu(), curr);
+
   struct thread *next = next_thread_to_run();  // ready_list에서 쓰레드 하나를 pop 함.
                                                // ready_list에서 뽑을 마땅한 쓰레드가 없다면 idle
                                                // 반환
@@ -731,14 +879,25 @@ static void schedule(void) {
   next->status = THREAD_RUNNING;  // next 쓰레드의 상태를 THREAD_RUNNING으로 바꿔준다.
 
   /* Start new time slice. */
-  thread_ticks = 0;  // 쓰레드가 yield 한 이후로 지난 시간, 0으로 세팅
+  this_cpu()->thread_ticks = 0;  // 쓰레드가 yield 한 이후로 지난 시간, 0으로 세팅
+  if (thread_fair) {
+    next->fair_slice_ran = 0;
+    next->fair_stamp = rdtsc();
+  }
 
 #ifdef USERPROG
   /* Activate the new address space. */
   process_activate(next);
 #endif
+  fpu_switch(next);  // next가 FPU 주인이 아니면 CR0.TS를 켜서 첫 FPU 명령에서 #NM이 나게 함
 
   if (curr != next) {
+    /* Charge the outgoing thread for its slice, in whatever mode
+       it was in, and start the incoming thread's clock. */
+    uint64_t now = rdtsc();
+    curr->cycles[curr->acct_mode] += now - curr->acct_stamp;
+    next->acct_stamp = now;
+
     /* If the thread we switched from is dying, destroy its struct
        thread. This must happen late so that thread_exit() doesn't
        pull out the rug under itself.
@@ -773,12 +932,6 @@ static tid_t allocate_tid(void) {
   return tid;
 }
 
-struct list *get_ready_list(void) {
-  return &ready_list;
-}
-struct list *get_sleep_list(void) {
-  return &sleep_list;
-}
 
 bool thread_priority_less(const struct list_elem *a, const struct list_elem *b, void *aux) {
   struct thread *thread_a = list_entry(a, struct thread, elem);
@@ -787,13 +940,354 @@ bool thread_priority_less(const struct list_elem *a, const struct list_elem *b,
   return thread_a->priority > thread_b->priority;
 }
 
-int max_priority_mlfqs_queue(void) {  // mlfqs에서 존재하는 ready_thread 중 가장 높은 우선순위를 반환
-  for (int i = PRI_MAX; i >= PRI_MIN; i--) {  // 우선순위 다중 ready 큐 순회, 우선순위 높은 순으로
-    if (!list_empty(&mlfqs_ready_queues[i - PRI_MIN])) {  //노드가 있는 큐를 찾았으면
-      return i;
+/* Returns the highest priority among this CPU's ready threads,
+   or -1 if every run queue is empty.  Interrupts must be off. */
+int thread_ready_max_priority(void) { return rq_max_priority(this_cpu()); }
+
+/* Sets T's effective priority to PRIORITY.  If T is on a run
+   queue it moves to the tail of the queue for its new priority,
+   exactly as if it had just been made ready.  If T sits in a
+   semaphore or condition variable wait heap it is re-keyed there,
+   keeping its place among waiters of equal priority. */
+void thread_set_effective_priority(struct thread *t, int priority) {
+  ASSERT(intr_get_level() == INTR_OFF);
+  ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
+
+  if (t->status == THREAD_READY) {
+    // cond_wait이 wait_heap을 정한 뒤 lock_release 전에 선점되면 READY이면서 대기 힙에도 있다
+    ready_queue_remove(t);
+    thread_rekey_priority(t, priority);
+    ready_queue_push(t);
+  } else
+    thread_rekey_priority(t, priority);
+}
+
+/* Sets T's priority to PRIORITY without touching any run queue.
+   If T sits in a semaphore or condition variable wait heap it is
+   re-keyed there, keeping its place among waiters of equal
+   priority. */
+static void thread_rekey_priority(struct thread *t, int priority) {
+  if (t->wait_heap != NULL) {  // 대기 힙 안의 키가 바뀌므로 뺐다가 다시 넣음 (도착 순번은 유지)
+    heap_remove(t->wait_heap, t->wait_node);
+    t->priority = priority;
+    heap_push(t->wait_heap, t->wait_node);
+  } else
+    t->priority = priority;
+}
+
+/* Returns T's priority including donations: the higher of its
+   own priority and that of the highest-priority waiter on any
+   lock it holds.  O(1), since held_locks is a heap. */
+int thread_effective_priority(const struct thread *t) {
+  int priority = t->original_priority;
+
+  if (!heap_empty(&t->held_locks)) {
+    struct lock *top = heap_entry(heap_top(&t->held_locks), struct lock, holder_elem);
+    if (top->max_priority > priority) priority = top->max_priority;
+  }
+  return priority;
+}
+
+/* held_locks 힙 비교 함수: 대기자 최대 우선순위가 큰 락이 위로 */
+static bool held_lock_less(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED) {
+  return heap_entry(a, struct lock, holder_elem)->max_priority < heap_entry(b, struct lock, holder_elem)->max_priority;
+}
+
+/* Charges the cycles since the last switch to the current
+   thread's present mode, enters MODE, and returns the mode it
+   left.  Called on system call, interrupt and exception entry
+   and exit. */
+enum thread_acct thread_acct_switch(enum thread_acct mode) {
+  enum intr_level old_level = intr_disable();
+  struct thread *curr = running_thread();
+  enum thread_acct old_mode = curr->acct_mode;
+  uint64_t now = rdtsc();
+
+  curr->cycles[old_mode] += now - curr->acct_stamp;
+  curr->acct_stamp = now;
+  curr->acct_mode = mode;
+  intr_set_level(old_level);
+  return old_mode;
+}
+
+/* Returns true if T is the idle thread of some CPU. */
+static bool is_idle(const struct thread *t) {
+  for (int c = 0; c < cpu_cnt; c++)
+    if (t == cpus[c].idle_thread) return true;
+  return false;
+}
+
+/* Returns true if C has no ready thread. */
+static bool rq_empty(const struct cpu *c) {
+  if (!heap_empty(&c->dl_queue)) return false;
+  return thread_fair ? rbtree_empty(&c->fair_queue) : c->ready_mask == 0;
+}
+
+/* Returns true if C holds a ready thread that should run before
+   CURR, so that CURR yielding would not be in vain. */
+static bool rq_preempts(const struct cpu *c, const struct thread *curr) {
+  if (curr->dl_period != 0)
+    return !heap_empty(&c->dl_queue) &&
+           dl_before(heap_entry(heap_top(&c->dl_queue), struct thread, dl_elem), curr);
+  if (thread_fair) return true;  // vruntime 순서가 정하므로 항상 트리에 다시 넣음
+  return rq_max_priority(c) >= curr->priority;
+}
+
+/* Returns the highest priority in C's run queues, or -1.  Ready
+   EDF threads count as PRI_DL, above every priority.  Otherwise
+   always -1 under the fair scheduler, which ignores priorities. */
+static int rq_max_priority(const struct cpu *c) {
+  uint64_t idx;
+
+  if (!heap_empty(&c->dl_queue)) return PRI_DL;
+  if (c->ready_mask == 0) return -1;  //아예 비어있다면
+  asm("bsrq %1, %0" : "=r"(idx) : "rm"(c->ready_mask));
+  return (int)idx + PRI_MIN;
+}
+
+/* Appends T to C's run queue for its priority.  Under mlfqs, T's
+   pending recent_cpu decay is applied first.  Under the fair
+   scheduler T goes into C's vruntime tree instead: a yielding T is
+   first charged for the cycles it just ran, and a waking T is
+   placed no more than half a period behind min_vruntime.  C's
+   rq_lock must be held. */
+static void rq_push(struct cpu *c, struct thread *t) {
+  mlfqs_settle(t);
+
+  if (t->dl_period != 0)
+    heap_push(&c->dl_queue, &t->dl_elem);
+  else if (thread_fair) {
+    uint64_t credit = fair_cycles(FAIR_LATENCY) / 2;
+
+    if (t->status == THREAD_RUNNING)
+      fair_update_curr(c, t);
+    else if (c->min_vruntime > credit && t->vruntime < c->min_vruntime - credit)
+      t->vruntime = c->min_vruntime - credit;
+    rbtree_insert(&c->fair_queue, &t->fair_node);
+    c->fair_load += fair_weight(t);
+  } else {
+    int idx = t->priority - PRI_MIN;
+
+    list_push_back(&c->ready_queues[idx], &t->elem);
+    c->ready_mask |= 1ULL << idx;
+  }
+  t->cpu = c - cpus;
+  if (!is_idle(t))  // idle thread는 카운트 하면 안되므로
+    c->ready_threads_count++;
+}
+
+/* Removes T from C's run queue for its priority.  C's rq_lock
+   must be held. */
+static void rq_remove(struct cpu *c, struct thread *t) {
+  int idx = t->priority - PRI_MIN;
+
+  ASSERT(t->cpu == c - cpus);
+  if (t->dl_period != 0)
+    heap_remove(&c->dl_queue, &t->dl_elem);
+  else if (thread_fair) {
+    rbtree_remove(&c->fair_queue, &t->fair_node);
+    c->fair_load -= fair_weight(t);
+  } else {
+    list_remove(&t->elem);
+    if (list_empty(&c->ready_queues[idx])) c->ready_mask &= ~(1ULL << idx);
+  }
+  if (!is_idle(t)) c->ready_threads_count--;
+}
+
+/* Removes and returns the first thread of C's highest nonempty
+   run queue, or under the fair scheduler the ready thread with
+   the least vruntime.  At least one thread must be ready.  Under
+   mlfqs, the first pick of a new decay epoch re-buckets every
+   ready thread first, so the pick order matches eager decay.
+   C's rq_lock must be held. */
+static struct thread *rq_pop(struct cpu *c) {
+  if (!heap_empty(&c->dl_queue)) {
+    struct thread *t = heap_entry(heap_top(&c->dl_queue), struct thread, dl_elem);
+
+    rq_remove(c, t);
+    return t;
+  }
+  if (thread_fair) {
+    struct thread *t = rb_entry(rbtree_first(&c->fair_queue), struct thread, fair_node);
+
+    rq_remove(c, t);
+    return t;
+  }
+  if (thread_mlfqs && c->rq_epoch != decay_epoch) rq_resettle(c);
+
+  int idx = rq_max_priority(c) - PRI_MIN;
+  struct thread *t = list_entry(list_front(&c->ready_queues[idx]), struct thread, elem);
+
+  rq_remove(c, t);
+  return t;
+}
+
+/* Settles every thread in C's run queues to the current decay
+   epoch and requeues it for its new priority.  Threads keep
+   their relative order within each old queue, higher queues
+   first.  C's rq_lock must be held. */
+static void rq_resettle(struct cpu *c) {
+  struct list stale;
+
+  list_init(&stale);
+  for (int idx = PRI_MAX - PRI_MIN; idx >= 0; idx--)
+    while (!list_empty(&c->ready_queues[idx])) {
+      struct thread *t = list_entry(list_front(&c->ready_queues[idx]), struct thread, elem);
+
+      rq_remove(c, t);
+      list_push_back(&stale, &t->elem);
     }
+  while (!list_empty(&stale))
+    rq_push(c, list_entry(list_pop_front(&stale), struct thread, elem));  // rq_push가 settle함
+  c->rq_epoch = decay_epoch;
+}
+
+/* Makes T ready on the current CPU. */
+static void ready_queue_push(struct thread *t) {
+  struct cpu *c = this_cpu();
+
+  spinlock_acquire(&c->rq_lock);
+  rq_push(c, t);
+  spinlock_release(&c->rq_lock);
+}
+
+/* Takes ready thread T off whichever CPU's run queue holds it. */
+static void ready_queue_remove(struct thread *t) {
+  struct cpu *c = &cpus[t->cpu];
+
+  spinlock_acquire(&c->rq_lock);
+  rq_remove(c, t);
+  spinlock_release(&c->rq_lock);
+}
+
+/* Returns true if T, just made ready, should preempt the running
+   thread. */
+static bool thread_should_preempt(struct thread *t) {
+  struct thread *curr = thread_current();
+
+  if (t->dl_period != 0 || curr->dl_period != 0) return is_idle(curr) || dl_before(t, curr);
+  if (!thread_fair) return t->priority > curr->priority;
+  if (is_idle(curr)) return true;
+
+  // 현재 쓰레드를 정산한 뒤, 깨어난 쓰레드가 충분히 뒤처져 있을 때만 선점
+  fair_update_curr(this_cpu(), curr);
+  return t->vruntime + fair_cycles(FAIR_WAKEUP_GRANULARITY) < curr->vruntime;
+}
+
+/* Converts TICKS timer ticks to TSC cycles. */
+static uint64_t fair_cycles(int64_t ticks) {
+  uint64_t tsc_per_tick = timer_tsc_per_tick();
+
+  return ticks * (tsc_per_tick != 0 ? tsc_per_tick : FAIR_TSC_PER_TICK);
+}
+
+/* Returns T's load weight for its nice value. */
+static uint64_t fair_weight(const struct thread *t) { return nice_weights[t->nice - NICE_MIN]; }
+
+/* Returns the cycles running thread T may run before yielding to
+   C's other ready threads: its weighted share of the scheduling
+   period, stretched when too many threads are ready for each to
+   get FAIR_MIN_GRANULARITY. */
+static uint64_t fair_slice(const struct cpu *c, const struct thread *t) {
+  uint64_t weight = fair_weight(t);
+  uint64_t min_gran = fair_cycles(FAIR_MIN_GRANULARITY);
+  uint64_t period = fair_cycles(FAIR_LATENCY);
+  uint64_t nr_ready = rbtree_size(&c->fair_queue) + 1;
+  uint64_t slice;
+
+  if (period < nr_ready * min_gran) period = nr_ready * min_gran;
+  slice = period * weight / (c->fair_load + weight);
+  return slice > min_gran ? slice : min_gran;
+}
+
+/* Charges running thread T, on C, with the cycles since it was
+   last charged, and advances C's min_vruntime.  Interrupts must be
+   off. */
+static void fair_update_curr(struct cpu *c, struct thread *t) {
+  uint64_t now, delta, floor;
+
+  if (is_idle(t) || t->dl_period != 0) return;
+  now = rdtsc();
+  delta = now - t->fair_stamp;
+  t->fair_stamp = now;
+  t->fair_slice_ran += delta;
+  t->vruntime += delta * NICE_0_WEIGHT / fair_weight(t);
+
+  // min_vruntime은 현재 쓰레드와 트리의 최솟값 중 작은 쪽을 따라가되 절대 줄어들지 않음
+  floor = t->vruntime;
+  if (!rbtree_empty(&c->fair_queue)) {
+    uint64_t first = rb_entry(rbtree_first(&c->fair_queue), struct thread, fair_node)->vruntime;
+    if (first < floor) floor = first;
+  }
+  if (floor > c->min_vruntime) c->min_vruntime = floor;
+}
+
+/* Called each timer tick for running thread T on C.  Returns true
+   if T has used up its slice and another thread is ready. */
+static bool fair_tick(struct cpu *c, struct thread *t) {
+  fair_update_curr(c, t);
+  return !rbtree_empty(&c->fair_queue) && t->fair_slice_ran >= fair_slice(c, t);
+}
+
+/* fair_queue 비교 함수: vruntime이 작은 쓰레드가 앞으로 */
+static bool fair_less(const struct rb_node *a, const struct rb_node *b, void *aux UNUSED) {
+  return rb_entry(a, struct thread, fair_node)->vruntime < rb_entry(b, struct thread, fair_node)->vruntime;
+}
+
+bool is_not_idle(struct thread *t) { return !is_idle(t); }
+
+/* Returns true if A should run before B under EDF: A is an EDF
+   thread and B is not, or both are and A's deadline is earlier. */
+static bool dl_before(const struct thread *a, const struct thread *b) {
+  if (a->dl_period == 0) return false;
+  return b->dl_period == 0 || a->dl_deadline < b->dl_deadline;
+}
+
+/* Charges EDF thread T, running at a timer tick, one tick of its
+   budget.  Returns true if T must give up the CPU: its budget ran
+   out, so it is throttled until its deadline, or it overran its
+   deadline and starts over with a later one, which another EDF
+   thread may now beat. */
+static bool dl_tick(struct thread *t) {
+  int64_t now = timer_ticks();
+
+  if (--t->dl_budget > 0) return false;
+  if (now >= t->dl_deadline) {  // 마감을 이미 넘겼으면 바로 다음 주기로
+    t->dl_deadline = now + t->dl_period;
+    t->dl_budget = t->dl_runtime;
+    return true;
+  }
+  t->dl_throttled = true;  // thread_yield()에서 잠들고, 마감 시각에 다시 채워짐
+  timer_add(&t->dl_timer, t->dl_deadline, dl_replenish, t);
+  return true;
+}
+
+/* Called as EDF thread T wakes up.  If T's remaining budget,
+   spent from now until its deadline, would exceed its reserved
+   bandwidth, T starts a new period with a full budget. */
+static void dl_wakeup(struct thread *t) {
+  int64_t now = timer_ticks();
+
+  if (t->dl_deadline <= now || t->dl_budget * t->dl_period > (t->dl_deadline - now) * t->dl_runtime) {
+    t->dl_deadline = now + t->dl_period;
+    t->dl_budget = t->dl_runtime;
   }
-  return -1;  //아예 비어있다면
 }
 
-bool is_not_idle(struct thread *t) { return t != idle_thread; }
+/* Timer callback for a throttled EDF thread T_: starts its next
+   period with a full budget and makes it runnable again. */
+static void dl_replenish(void *t_) {
+  struct thread *t = t_;
+  int64_t now = timer_ticks();
+
+  t->dl_deadline += t->dl_period;
+  if (t->dl_deadline <= now) t->dl_deadline = now + t->dl_period;
+  t->dl_budget = t->dl_runtime;
+  t->dl_throttled = false;
+  thread_unblock(t);
+}
+
+/* dl_queue 비교 함수: 마감 시각이 이른 쓰레드가 위로 */
+static bool dl_less(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED) {
+  return heap_entry(a, struct thread, dl_elem)->dl_deadline > heap_entry(b, struct thread, dl_elem)->dl_deadline;
+}
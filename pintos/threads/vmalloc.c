@@ -0,0 +1,195 @@
+#include "threads/vmalloc.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdio.h>
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/pte.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* Virtually contiguous kernel allocations.
+
+   The region from VMALLOC_START to VMALLOC_END is handed out
+   first fit.  Each allocation is followed by one unmapped guard
+   page, so that running off the end of a table faults instead of
+   silently corrupting its neighbour.
+
+   Page tables for the region are created on demand in base_pml4
+   and never freed.  They hang below the kernel's top-level entry,
+   which pml4_create() copies into every process's page table, so
+   new mappings appear there without further work. */
+
+/* An allocated range of the region. */
+struct vm_area {
+	struct list_elem elem;      /* Element in `areas', sorted by addr. */
+	uint8_t *addr;              /* First page. */
+	size_t page_cnt;            /* Number of mapped pages. */
+};
+
+static struct list areas;
+static struct lock vmalloc_lock;
+
+static struct vm_area *find_area (const void *);
+static void unmap_pages (uint8_t *, size_t page_cnt);
+
+/* Initializes the vmalloc() region.  Must be called after
+   paging_init(). */
+void
+vmalloc_init (void) {
+	list_init (&areas);
+	lock_init_named (&vmalloc_lock, "vmalloc");
+}
+
+/* Obtains and returns SIZE bytes of virtually contiguous kernel
+   memory, rounded up to whole pages.  FLAGS may include PAL_ZERO,
+   PAL_ASSERT and PAL_TAG; the pages are charged to the given tag.
+   Returns a null pointer if SIZE is 0 or if either address space
+   or memory is not available, unless PAL_ASSERT is set, in which
+   case the kernel panics. */
+void *
+vmalloc (size_t size, enum palloc_flags flags) {
+	enum mem_tag tag = flags >> PAL_TAG_SHIFT;
+	size_t page_cnt = DIV_ROUND_UP (size, PGSIZE);
+	struct vm_area *area;
+	struct list_elem *e;
+	uint64_t start;
+	size_t i;
+
+	ASSERT (!(flags & PAL_USER));
+
+	if (page_cnt == 0)
+		return NULL;
+	area = malloc_tagged (sizeof *area, tag);
+	if (area == NULL)
+		goto fail;
+	area->page_cnt = page_cnt;
+
+	/* Reserve the first gap that fits the pages and a guard page. */
+	lock_acquire (&vmalloc_lock);
+	start = VMALLOC_START;
+	for (e = list_begin (&areas); e != list_end (&areas); e = list_next (e)) {
+		struct vm_area *a = list_entry (e, struct vm_area, elem);
+
+		if ((uint64_t) a->addr - start >= (page_cnt + 1) * PGSIZE)
+			break;
+		start = (uint64_t) a->addr + (a->page_cnt + 1) * PGSIZE;
+	}
+	if (VMALLOC_END - start < (page_cnt + 1) * PGSIZE) {
+		lock_release (&vmalloc_lock);
+		free (area);
+		goto fail;
+	}
+	area->addr = (uint8_t *) start;
+	list_insert (e, &area->elem);
+	lock_release (&vmalloc_lock);
+
+	/* Back the range with pages one at a time. */
+	for (i = 0; i < page_cnt; i++) {
+		uint8_t *va = area->addr + i * PGSIZE;
+		void *kpage = palloc_get_page (flags & ~PAL_ASSERT);
+		uint64_t *pte;
+
+		if (kpage == NULL)
+			break;
+		pte = pml4e_walk (base_pml4, (uint64_t) va, 1);
+		if (pte == NULL) {
+			palloc_free_page (kpage);
+			break;
+		}
+		ASSERT (!(*pte & PTE_P));
+		*pte = vtop (kpage) | PTE_P | PTE_W;
+	}
+	if (i < page_cnt) {
+		unmap_pages (area->addr, i);
+		lock_acquire (&vmalloc_lock);
+		list_remove (&area->elem);
+		lock_release (&vmalloc_lock);
+		free (area);
+		goto fail;
+	}
+	return area->addr;
+
+fail:
+	if (flags & PAL_ASSERT)
+		PANIC ("vmalloc: out of memory for %zu bytes", size);
+	return NULL;
+}
+
+/* Frees P, which must have been returned by vmalloc().  If P is
+   a null pointer, does nothing. */
+void
+vfree (void *p) {
+	struct vm_area *area;
+
+	if (p == NULL)
+		return;
+	ASSERT (is_vmalloc_addr (p));
+
+	lock_acquire (&vmalloc_lock);
+	area = find_area (p);
+	ASSERT (area != NULL);
+	list_remove (&area->elem);
+	lock_release (&vmalloc_lock);
+
+	unmap_pages (area->addr, area->page_cnt);
+	free (area);
+}
+
+/* Prints how much of the region is in use. */
+void
+vmalloc_print_stats (void) {
+	struct list_elem *e;
+	size_t area_cnt = 0, page_cnt = 0;
+
+	lock_acquire (&vmalloc_lock);
+	for (e = list_begin (&areas); e != list_end (&areas); e = list_next (e)) {
+		area_cnt++;
+		page_cnt += list_entry (e, struct vm_area, elem)->page_cnt;
+	}
+	lock_release (&vmalloc_lock);
+
+	if (area_cnt > 0)
+		printf ("vmalloc: %zu areas, %zu pages\n", area_cnt, page_cnt);
+}
+
+/* Returns the area that starts at P, or a null pointer.  The
+   caller must hold vmalloc_lock. */
+static struct vm_area *
+find_area (const void *p) {
+	struct list_elem *e;
+
+	ASSERT (lock_held_by_current_thread (&vmalloc_lock));
+
+	for (e = list_begin (&areas); e != list_end (&areas); e = list_next (e)) {
+		struct vm_area *a = list_entry (e, struct vm_area, elem);
+
+		if (a->addr == p)
+			return a;
+		if (a->addr > (uint8_t *) p)
+			break;
+	}
+	return NULL;
+}
+
+/* Unmaps the PAGE_CNT pages starting at ADDR and returns them to
+   the page allocator. */
+static void
+unmap_pages (uint8_t *addr, size_t page_cnt) {
+	size_t i;
+
+	for (i = 0; i < page_cnt; i++) {
+		uint8_t *va = addr + i * PGSIZE;
+		uint64_t *pte = pml4e_walk (base_pml4, (uint64_t) va, 0);
+		void *kpage;
+
+		ASSERT (pte != NULL && (*pte & PTE_P));
+		kpage = ptov (PTE_ADDR (*pte));
+		*pte = 0;
+		invlpg ((uint64_t) va);
+		palloc_free_page (kpage);
+	}
+}
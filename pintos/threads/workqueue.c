@@ -0,0 +1,238 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Number of worker threads in the pool. */
+#define WORKQUEUE_WORKERS 2
+
+/* All workqueues, highest priority first.  Like the lists inside
+   each queue, this is protected by turning interrupts off, so
+   that queue_work() can be called from interrupt handlers. */
+static struct list workqueues;
+
+/* Upped whenever a queue may have become runnable.  Idle workers
+   wait here. */
+static struct semaphore work_avail;
+
+struct workqueue system_wq;
+
+/* A thread blocked in flush_work() or flush_workqueue(). */
+struct flusher {
+	uint64_t seq;               /* Wake once done_seq reaches this. */
+	struct semaphore sema;      /* Upped by the worker. */
+	struct list_elem elem;      /* Element in the queue's flushers. */
+};
+
+static thread_func worker;
+static bool workqueue_priority_more (const struct list_elem *,
+		const struct list_elem *, void *aux);
+static void wait_for_seq (struct workqueue *, uint64_t seq);
+
+/* Creates the worker pool and the system workqueue.  Must be
+   called after thread_start(). */
+void
+workqueue_init (void) {
+	int i;
+
+	list_init (&workqueues);
+	sema_init (&work_avail, 0);
+	workqueue_create (&system_wq, "system", PRI_DEFAULT);
+
+	for (i = 0; i < WORKQUEUE_WORKERS; i++) {
+		char name[16];
+
+		snprintf (name, sizeof name, "kworker/%d", i);
+		thread_create (name, PRI_MAX, worker, NULL);
+	}
+}
+
+/* Initializes WQ as an empty queue named NAME whose items run at
+   PRIORITY, and makes it visible to the workers. */
+void
+workqueue_create (struct workqueue *wq, const char *name, int priority) {
+	enum intr_level old_level;
+
+	ASSERT (wq != NULL);
+	ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+
+	wq->name = name;
+	wq->priority = priority;
+	list_init (&wq->pending);
+	wq->queued_seq = wq->done_seq = 0;
+	wq->busy = false;
+	list_init (&wq->flushers);
+
+	old_level = intr_disable ();
+	list_insert_ordered (&workqueues, &wq->elem,
+			workqueue_priority_more, NULL);
+	intr_set_level (old_level);
+}
+
+/* Initializes W to run FUNC. */
+void
+work_init (struct work *w, work_func *func) {
+	ASSERT (w != NULL);
+	ASSERT (func != NULL);
+
+	w->func = func;
+	w->wq = NULL;
+	w->seq = 0;
+	w->pending = false;
+}
+
+/* Queues W on WQ.  Returns false, doing nothing, if W is already
+   pending.  Never sleeps, so it may be called from an interrupt
+   handler. */
+bool
+queue_work (struct workqueue *wq, struct work *w) {
+	enum intr_level old_level;
+	bool wake;
+
+	ASSERT (wq != NULL);
+	ASSERT (w != NULL);
+
+	old_level = intr_disable ();
+	if (w->pending) {
+		intr_set_level (old_level);
+		return false;
+	}
+	wake = list_empty (&wq->pending) && !wq->busy;
+	w->wq = wq;
+	w->seq = ++wq->queued_seq;
+	w->pending = true;
+	list_push_back (&wq->pending, &w->elem);
+	if (wake)
+		sema_up (&work_avail);
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Waits until W, if it is pending or running, has finished.  W
+   must still exist, so a function that frees its own work item
+   cannot be flushed this way; flush its queue instead. */
+void
+flush_work (struct work *w) {
+	enum intr_level old_level;
+
+	ASSERT (w != NULL);
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	if (w->wq != NULL)
+		wait_for_seq (w->wq, w->seq);
+	intr_set_level (old_level);
+}
+
+/* Waits until every item queued on WQ before this call has
+   finished.  Items queued meanwhile are not waited for. */
+void
+flush_workqueue (struct workqueue *wq) {
+	enum intr_level old_level;
+
+	ASSERT (wq != NULL);
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	wait_for_seq (wq, wq->queued_seq);
+	intr_set_level (old_level);
+}
+
+/* Blocks until WQ's done_seq reaches SEQ.  Interrupts must be
+   off. */
+static void
+wait_for_seq (struct workqueue *wq, uint64_t seq) {
+	struct flusher f;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (wq->done_seq >= seq)
+		return;
+	f.seq = seq;
+	sema_init (&f.sema, 0);
+	list_push_back (&wq->flushers, &f.elem);
+	sema_down (&f.sema);
+}
+
+/* Returns the highest-priority queue with pending items that no
+   other worker is serving, or NULL.  Interrupts must be off. */
+static struct workqueue *
+pick_workqueue (void) {
+	struct list_elem *e;
+
+	for (e = list_begin (&workqueues); e != list_end (&workqueues);
+			e = list_next (e)) {
+		struct workqueue *wq = list_entry (e, struct workqueue, elem);
+		if (!wq->busy && !list_empty (&wq->pending))
+			return wq;
+	}
+	return NULL;
+}
+
+/* Worker thread.  Takes a batch from the best queue, runs it at
+   the queue's priority, records its completion, and repeats.
+   Idles at PRI_MAX so that a wakeup is acted on at once. */
+static void
+worker (void *aux UNUSED) {
+	for (;;) {
+		struct list batch;
+		struct workqueue *wq;
+		uint64_t last_seq = 0;
+		struct list_elem *e;
+		int n;
+
+		intr_disable ();
+		wq = pick_workqueue ();
+		if (wq == NULL) {
+			intr_enable ();
+			thread_set_priority (PRI_MAX);
+			sema_down (&work_avail);
+			continue;
+		}
+
+		/* Detach up to WORKQUEUE_BATCH items. */
+		list_init (&batch);
+		for (n = 0; n < WORKQUEUE_BATCH && !list_empty (&wq->pending); n++) {
+			struct work *w = list_entry (list_pop_front (&wq->pending),
+					struct work, elem);
+			w->pending = false;
+			list_push_back (&batch, &w->elem);
+		}
+		wq->busy = true;
+		intr_enable ();
+
+		thread_set_priority (wq->priority);
+		while (!list_empty (&batch)) {
+			struct work *w = list_entry (list_pop_front (&batch),
+					struct work, elem);
+			/* W may be freed or requeued by its function. */
+			last_seq = w->seq;
+			w->func (w);
+		}
+
+		intr_disable ();
+		wq->done_seq = last_seq;
+		wq->busy = false;
+		for (e = list_begin (&wq->flushers); e != list_end (&wq->flushers); ) {
+			struct flusher *f = list_entry (e, struct flusher, elem);
+			e = list_next (e);
+			if (f->seq <= wq->done_seq) {
+				list_remove (&f->elem);
+				sema_up (&f->sema);
+			}
+		}
+		intr_enable ();
+	}
+}
+
+/* Orders workqueues by descending priority. */
+static bool
+workqueue_priority_more (const struct list_elem *a_,
+		const struct list_elem *b_, void *aux UNUSED) {
+	const struct workqueue *a = list_entry (a_, struct workqueue, elem);
+	const struct workqueue *b = list_entry (b_, struct workqueue, elem);
+
+	return a->priority > b->priority;
+}
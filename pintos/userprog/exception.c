@@ -2,6 +2,7 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "threads/fpu.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "intrinsic.h"
@@ -12,6 +13,7 @@ static long long page_fault_cnt;
 
 static void kill (struct intr_frame *);
 static void page_fault (struct intr_frame *);
+static void device_not_available (struct intr_frame *);
 
 /* Registers handlers for interrupts that can be caused by user
    programs.
@@ -46,8 +48,6 @@ exception_init (void) {
 	intr_register_int (0, 0, INTR_ON, kill, "#DE Divide Error");
 	intr_register_int (1, 0, INTR_ON, kill, "#DB Debug Exception");
 	intr_register_int (6, 0, INTR_ON, kill, "#UD Invalid Opcode Exception");
-	intr_register_int (7, 0, INTR_ON, kill,
-			"#NM Device Not Available Exception");
 	intr_register_int (11, 0, INTR_ON, kill, "#NP Segment Not Present");
 	intr_register_int (12, 0, INTR_ON, kill, "#SS Stack Fault Exception");
 	intr_register_int (13, 0, INTR_ON, kill, "#GP General Protection Exception");
@@ -59,6 +59,13 @@ exception_init (void) {
 	   We need to disable interrupts for page faults because the
 	   fault address is stored in CR2 and needs to be preserved. */
 	intr_register_int (14, 0, INTR_OFF, page_fault, "#PF Page-Fault Exception");
+
+	/* #NM is how the FPU is handed between threads lazily: the
+	   scheduler sets CR0.TS, and the first FPU instruction after
+	   that traps here.  Interrupts stay off until the handler has
+	   decided who owns the FPU. */
+	intr_register_int (7, 0, INTR_OFF, device_not_available,
+			"#NM Device Not Available Exception");
 }
 
 /* Prints exception statistics. */
@@ -103,6 +110,15 @@ kill (struct intr_frame *f) {
 	}
 }
 
+/* #NM handler.  Loads the running thread's FPU state, saving the
+   previous owner's first.  If that is impossible the thread is
+   treated like any other faulting process. */
+static void
+device_not_available (struct intr_frame *f) {
+	if (!fpu_handle_trap ())
+		kill (f);
+}
+
 /* Page fault handler.  This is a skeleton that must be filled in
    to implement virtual memory.  Some solutions to project 2 may
    also require modifying this code.
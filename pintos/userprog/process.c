@@ -12,9 +12,11 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "threads/flags.h"
+#include "threads/fpu.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
@@ -30,6 +32,9 @@
 
 extern struct lock filesys_lock;
 
+/* struct child_status 전용 슬랩 캐시 */
+static struct kmem_cache *child_status_cache;
+
 static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
 static void initd (void *f_name);
@@ -68,6 +73,15 @@ struct load_aux {
 #endif
 
 
+/* Creates the caches used by process creation.  Called once at
+ * boot, before the first process starts. */
+/* 프로세스 생성에 쓰는 캐시를 만든다. 부팅 중 첫 프로세스 이전에 한 번 호출된다. */
+void
+process_cache_init (void) {
+	child_status_cache = kmem_cache_create ("child_status",
+			sizeof (struct child_status), NULL, MEM_PROCESS);
+}
+
 /* General process initializer for initd and other process. */
 /* initd 및 기타 프로세스를 위한 일반 초기화 함수. */
 static void
@@ -124,7 +138,7 @@ process_create_initd (const char *file_name) {
 	 * Otherwise there's a race between the caller and load(). */
 	/* FILE_NAME의 복사본을 만든다.
 	 * 그렇지 않으면 호출자와 load() 사이에서 경쟁 상태가 생길 수 있다. */
-	fn_copy = palloc_get_page (0);
+	fn_copy = palloc_get_page (PAL_TAG (MEM_PROCESS));
 	if (fn_copy == NULL)
 		return TID_ERROR;
 	strlcpy (fn_copy, file_name, PGSIZE);
@@ -136,7 +150,7 @@ process_create_initd (const char *file_name) {
 		tname[i++] = file_name[i];
 	tname[i] = '\0';
 
-	struct child_status *cs = malloc(sizeof *cs);
+	struct child_status *cs = kmem_cache_alloc(child_status_cache);
 	if (!cs) { palloc_free_page(fn_copy);
 		return TID_ERROR; }
 
@@ -149,11 +163,12 @@ process_create_initd (const char *file_name) {
 	sema_init(&cs->load_sema, 0);
 	cs->load_done = false;
 	cs->load_ok = false;
+	memset(cs->cycles, 0, sizeof cs->cycles);
 	list_push_back(&thread_current()->children, &cs->elem);
 
-	struct exec_info *ei = malloc(sizeof *ei);
+	struct exec_info *ei = malloc_tagged(sizeof *ei, MEM_PROCESS);
 	if (!ei) { 
-		list_remove(&cs->elem); free(cs); palloc_free_page(fn_copy);
+		list_remove(&cs->elem); kmem_cache_free(child_status_cache, cs); palloc_free_page(fn_copy);
 		return TID_ERROR; }
 	ei->cmdline = fn_copy;
 	ei->cs = cs;
@@ -163,7 +178,7 @@ process_create_initd (const char *file_name) {
 	tid = thread_create (tname, PRI_DEFAULT, initd, ei);
 	if (tid == TID_ERROR) {
 		list_remove(&cs->elem);
-		free(cs);
+		kmem_cache_free(child_status_cache, cs);
 		palloc_free_page (fn_copy);
 		free(ei);
 		return TID_ERROR;
@@ -182,7 +197,7 @@ initd (void *aux_) {
 	struct thread *cur = thread_current();
 
 	if (cur->fd_table == NULL || cur->fd_cap == 0) {
-    cur->fd_table = (struct file **)palloc_get_page(PAL_ZERO);
+    cur->fd_table = (struct file **)palloc_get_page(PAL_ZERO | PAL_TAG(MEM_PROCESS));
     if (cur->fd_table == NULL)
       PANIC("fd_table alloc failed");
     cur->fd_cap = PGSIZE / (int)sizeof(cur->fd_table[0]);
@@ -222,7 +237,7 @@ process_fork (const char *name, struct intr_frame *if_ UNUSED) {
 	struct thread *parent = thread_current();
 
 	// 1) child_status 노드 생성 + 부모 children에 등록
-	struct child_status *cs = malloc(sizeof *cs);
+	struct child_status *cs = kmem_cache_alloc(child_status_cache);
 	if (!cs) return TID_ERROR;
 	cs->tid = TID_ERROR;
 	cs->exit_code = -1;
@@ -233,12 +248,13 @@ process_fork (const char *name, struct intr_frame *if_ UNUSED) {
 	sema_init(&cs->load_sema, 0);    // fork에서는 안 쓰지만 구조체 일관성
 	cs->load_done = true;            // fork 경로는 사용 안 함
 	cs->load_ok = true;
+	memset(cs->cycles, 0, sizeof cs->cycles);
 	list_push_back(&parent->children, &cs->elem);
 
 	/* Clone current thread to new thread.*/
 	/* 현재 스레드를 새 스레드로 복제. */
-	struct fork_args *fa = malloc(sizeof *fa);
-	if (!fa) { list_remove(&cs->elem); free(cs); return TID_ERROR; }
+	struct fork_args *fa = malloc_tagged(sizeof *fa, MEM_PROCESS);
+	if (!fa) { list_remove(&cs->elem); kmem_cache_free(child_status_cache, cs); return TID_ERROR; }
 	fa->parent = parent;
 	memcpy(&fa->parent_if, if_, sizeof *if_);
 	fa->cs = cs;
@@ -246,7 +262,7 @@ process_fork (const char *name, struct intr_frame *if_ UNUSED) {
 	tid_t tid = thread_create (name, PRI_DEFAULT, __do_fork, fa);
 	if (tid == TID_ERROR) {
 		list_remove(&cs->elem);
-		free(cs);
+		kmem_cache_free(child_status_cache, cs);
 		free(fa);
 		return TID_ERROR;
 	}
@@ -255,7 +271,7 @@ process_fork (const char *name, struct intr_frame *if_ UNUSED) {
 	sema_down(&cs->load_sema);
 	if (!cs->load_ok) {
 		list_remove(&cs->elem);
-		if (--cs->ref_cnt == 0) free(cs);
+		if (--cs->ref_cnt == 0) kmem_cache_free(child_status_cache, cs);
 		return TID_ERROR;
 	}
 	return tid;
@@ -283,7 +299,7 @@ duplicate_pte (uint64_t *pte, void *va, void *aux) {
 	/* 3. TODO: Allocate new PAL_USER page for the child and set result to
 	 *    TODO: NEWPAGE. */
 	/* 3. TODO: 자식용 PAL_USER 페이지를 새로 할당하고 결과를 NEWPAGE에 저장한다. */
-	void *newpage = palloc_get_page(PAL_USER);
+	void *newpage = palloc_get_page(PAL_USER | PAL_TAG(MEM_PROCESS));
 	if (newpage == NULL) return false;
 
 	/* 4. TODO: Duplicate parent's page to the new page and
@@ -352,6 +368,10 @@ __do_fork (void *aux) {
 		goto error;
 #endif
 
+	/* 부모가 FPU를 썼다면 그 레지스터 상태도 물려준다. */
+	if (!fpu_fork (parent))
+		goto error;
+
 	/* TODO: Your code goes here.
 	 * TODO: Hint) To duplicate the file object, use `file_duplicate`
 	 * TODO:       in include/filesys/file.h. Note that parent should not return
@@ -365,7 +385,7 @@ __do_fork (void *aux) {
 	if (parent->fd_table && parent->fd_cap > 0) {
 		current->fd_cap = parent->fd_cap;
 
-		current->fd_table = palloc_get_page(PAL_ZERO);
+		current->fd_table = palloc_get_page(PAL_ZERO | PAL_TAG(MEM_PROCESS));
 		if (!current->fd_table) goto error;
 		current->fd_table_from_palloc = true;
 	
@@ -401,7 +421,7 @@ __do_fork (void *aux) {
 				current->fd_table[i] = nf;
 
 				// 매핑 등록
-				ent = malloc(sizeof *ent);
+				ent = malloc_tagged(sizeof *ent, MEM_PROCESS);
 				if (!ent) goto fork_rollback;
 				ent->parent_fp = p;
 				ent->child_fp  = nf;
@@ -421,6 +441,7 @@ __do_fork (void *aux) {
 
 	/* Finally, switch to the newly created process. */
 	/* 마지막으로 새로 생성한 프로세스로 전환한다. */
+	thread_acct_switch (ACCT_USER);
 	do_iret (&if_);
 fork_rollback:
 	for (int j = 0; j < parent->fd_cap; j++) {
@@ -580,6 +601,7 @@ process_exec (void *f_name) {
 
 	/* Start switched process. */
 	/* 전환된 프로세스를 시작한다. */
+	thread_acct_switch (ACCT_USER);
 	do_iret (&_if);
 	NOT_REACHED ();
 }
@@ -587,7 +609,7 @@ process_exec (void *f_name) {
 static void fd_table_init(struct thread *t) {
   if (t->fd_table) return;           // 중복 방지
   t->fd_cap   = 64;
-  t->fd_table = calloc(t->fd_cap, sizeof *t->fd_table);
+  t->fd_table = calloc_tagged(t->fd_cap, sizeof *t->fd_table, MEM_PROCESS);
   /* 0(stdin),1(stdout)은 예약
    * 테이블은 2부터 사용
    */
@@ -630,11 +652,13 @@ process_wait (tid_t child_tid UNUSED) {
 				sema_down(&cs->sema);
 
 			int ex_code = cs->exit_code;
+			for (int m = 0; m < ACCT_CNT; m++)
+				cur->child_cycles[m] += cs->cycles[m];   // 거둔 자식의 사용 시간 합산
 			
 			list_remove(&cs->elem);
 
 			if (--cs->ref_cnt == 0)
-				free(cs);
+				kmem_cache_free(child_status_cache, cs);
 			
 			return ex_code;
 		}
@@ -694,12 +718,15 @@ process_exit (void) {
 
 
 		if (cur->my_status) {
+			thread_acct_switch (ACCT_SYS);   // 지금까지 사용한 사이클 정산
+			for (int m = 0; m < ACCT_CNT; m++)
+				cur->my_status->cycles[m] = cur->cycles[m] + cur->child_cycles[m];
 			cur->my_status->exit_code = cur->exit_status;
 			cur->my_status->exited = true;
 			sema_up(&cur->my_status->sema);
 
 			if (--cur->my_status->ref_cnt == 0)
-				free(cur->my_status);
+				kmem_cache_free(child_status_cache, cur->my_status);
 			cur->my_status = NULL;
 		}
 
@@ -709,7 +736,7 @@ process_exit (void) {
 			struct list_elem *e = list_pop_front(&cur->children);	
 			struct child_status *cs = list_entry(e, struct child_status, elem);
 			if (--cs->ref_cnt == 0)
-				free(cs);
+				kmem_cache_free(child_status_cache, cs);
 		}
 	}
 	process_cleanup ();
@@ -721,6 +748,9 @@ static void
 process_cleanup (void) {
 	struct thread *curr = thread_current ();
 
+	/* exec 이후엔 깨끗한 FPU 상태로 시작해야 하므로 버린다. */
+	fpu_release (curr);
+
 #ifdef VM
 	supplemental_page_table_kill (&curr->spt);
 #endif
@@ -1104,7 +1134,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 
 		/* Get a page of memory. */
 		/* 메모리 페이지를 하나 할당한다. */
-		uint8_t *kpage = palloc_get_page (PAL_USER);
+		uint8_t *kpage = palloc_get_page (PAL_USER | PAL_TAG (MEM_PROCESS));
 		if (kpage == NULL)
 			return false;
 
@@ -1140,7 +1170,7 @@ setup_stack (struct intr_frame *if_) {
 	uint8_t *kpage;
 	bool success = false;
 
-	kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+	kpage = palloc_get_page (PAL_USER | PAL_ZERO | PAL_TAG (MEM_PROCESS));
 	if (kpage != NULL) {
 		success = install_page (((uint8_t *) USER_STACK) - PGSIZE, kpage, true);
 		if (success)
@@ -1263,7 +1293,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 
 		/* TODO: Set up aux to pass information to the lazy_load_segment. */
 		/* TODO: lazy_load_segment에 정보를 전달하기 위한 aux를 설정한다. */
-		struct load_aux *aux = malloc(sizeof *aux);
+		struct load_aux *aux = malloc_tagged(sizeof *aux, MEM_VM);
 		if (!aux) return false;
 		// aux->file = file_reopen(file);
 		// if (aux->file == NULL) { free(aux); return false; }
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <syscall-nr.h>
+#include <rusage.h>
 #include "threads/thread.h"
 #include "threads/loader.h"
 #include "userprog/gdt.h"
@@ -14,6 +15,7 @@
 #include "threads/vaddr.h"   // is_user_vaddr()
 #include "threads/mmu.h"     // pml4_get_page()
 #include "devices/input.h"   // input_getc()
+#include "threads/malloc.h"  // malloc_tagged, free
 #include "threads/palloc.h"  // palloc_get_page, palloc_free_page
 #include "userprog/process.h"
 #include "threads/synch.h"
@@ -78,6 +80,8 @@ static unsigned system_tell(int fd);
 
 static int system_dup2(int oldfd, int newfd);
 
+static int system_getrusage(int who, struct rusage *usage);
+
 #ifdef VM
 static void *system_mmap(void *addr, size_t length, int writable, int fd, off_t offset);
 static void  system_munmap(void *addr);
@@ -109,7 +113,14 @@ kmap_user_addr_or_claim(const void *uaddr, bool for_write) {
   if (kp != NULL) {
     struct page *p = spt_find_page(&t->spt, upg);
     if (for_write && p && !p->writable) system_exit(-1);
-    return (uint8_t *)kp + pg_ofs(uaddr);
+    /* fork가 공유시킨 읽기 전용 매핑이면 먼저 사본을 받는다.
+     * 커널 별칭으로 쓰는 건 CR0.WP에 걸리지 않아 그대로 두면 상대 프로세스의 메모리가 바뀐다 */
+    if (for_write && p && !pml4_is_writable(t->pml4, upg)) {
+      if (!vm_handle_wp(p)) system_exit(-1);
+      kp = pml4_get_page(t->pml4, upg);
+    }
+    /* 사본을 받는 사이 축출됐으면 아래에서 다시 올린다 */
+    if (kp != NULL) return (uint8_t *)kp + pg_ofs(uaddr);
   }
 
   /* 2) SPT에 등록된 페이지면 claim해서 매핑 */
@@ -199,7 +210,7 @@ syscall_init (void) {
 	write_msr(MSR_SYSCALL_MASK,
 			FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
 
-  lock_init(&filesys_lock);
+  lock_init_named(&filesys_lock, "filesys");
   // list_init(&file_ref_list);
   lock_init(&file_ref_lock);
   hash_init(&file_ref_ht, file_ref_hash, file_ref_less, NULL);
@@ -210,6 +221,7 @@ syscall_init (void) {
 /* 개쩌는 가시성 (아님) */
 void syscall_handler(struct intr_frame *f) {
   thread_current()->user_rsp = f->rsp;
+  thread_acct_switch(ACCT_SYS);  // 여기서부터는 시스템 시간
   switch (SC_NO(f)) {
     case SYS_HALT:   system_halt(); __builtin_unreachable();
     case SYS_EXIT:   system_exit((int)ARG0(f)); __builtin_unreachable();
@@ -236,6 +248,8 @@ void syscall_handler(struct intr_frame *f) {
     /* dup2 extra 과제 */
     case SYS_DUP2:   RET(f, system_dup2((int)ARG0(f), (int)ARG1(f))); break;
 
+    case SYS_GETRUSAGE: RET(f, system_getrusage((int)ARG0(f), (struct rusage *)ARG1(f))); break;
+
 #ifdef VM
     case SYS_MMAP:   RET(f, system_mmap((void *)ARG0(f), (size_t)ARG1(f), (int)ARG2(f),
                         (int)ARG3(f), (off_t)ARG4(f))); break;
@@ -244,6 +258,7 @@ void syscall_handler(struct intr_frame *f) {
 
     default:         system_exit(-1); __builtin_unreachable();
   }
+  thread_acct_switch(ACCT_USER);  // 유저로 복귀
 }
 
 
@@ -280,7 +295,7 @@ system_fork(const char *thread_name, struct intr_frame *parent_if) {
 
 static int
 system_exec(const char *cmdline) {
-  char *create = palloc_get_page(0);
+  char *create = palloc_get_page(PAL_TAG(MEM_SYSCALL));
   if (!create) return -1;
   if (!copy_in_string(create, cmdline, PGSIZE)) {
     palloc_free_page(create);
@@ -399,7 +414,7 @@ system_read(int fd, void *buffer, unsigned size) {
 
   if (f == STDOUT_FD) return -1;
 
-  void *read_page = palloc_get_page(PAL_ZERO);
+  void *read_page = palloc_get_page(PAL_ZERO | PAL_TAG(MEM_SYSCALL));
   if (read_page == NULL) return -1;
 
   int total = 0;
@@ -426,7 +441,7 @@ system_write (int fd, const void *buf, unsigned size) {
   if (size == 0) return 0;
   if (buf == NULL) system_exit(-1);
 
-  void *kpage = palloc_get_page(0);
+  void *kpage = palloc_get_page(PAL_TAG(MEM_SYSCALL));
   if (!kpage) return -1;
 
   long total = 0;
@@ -501,6 +516,28 @@ system_dup2(int oldfd, int newfd) {
   return newfd;
 }
 
+// 호출자(RUSAGE_SELF) 또는 거둔 자식들(RUSAGE_CHILDREN)의 사이클 사용량
+static int
+system_getrusage(int who, struct rusage *usage) {
+  struct thread *t = thread_current();
+  const uint64_t *cycles;
+  struct rusage ru;
+
+  if (who == RUSAGE_SELF) {
+    thread_acct_switch(ACCT_SYS);  // 지금까지의 사이클 정산
+    cycles = t->cycles;
+  } else if (who == RUSAGE_CHILDREN)
+    cycles = t->child_cycles;
+  else
+    return -1;
+
+  ru.ru_user_cycles = cycles[ACCT_USER];
+  ru.ru_sys_cycles = cycles[ACCT_SYS];
+  ru.ru_irq_cycles = cycles[ACCT_IRQ];
+  copy_out(usage, &ru, sizeof ru);
+  return 0;
+}
+
 #ifdef VM
 static void *system_mmap(void *addr, size_t length, int writable, int fd, off_t offset) {
   /* 규격 검증 */
@@ -638,7 +675,7 @@ fd_ensure_table(void) {
   if (t->fd_table && t->fd_cap > 0) return true;
 
   int cap = FD_GROW_STEP;
-  struct file **newtab = (struct file **)palloc_get_page(PAL_ZERO);
+  struct file **newtab = (struct file **)palloc_get_page(PAL_ZERO | PAL_TAG(MEM_PROCESS));
   if (!newtab) return false;
 
   t->fd_table = newtab;
@@ -682,7 +719,7 @@ fdref_inc(struct file *fp) {
   lock_acquire(&file_ref_lock);
   struct file_ref *r = ref_find(fp);
   if (!r) {
-    r = malloc(sizeof *r);
+    r = malloc_tagged(sizeof *r, MEM_SYSCALL);
     if (!r) {                      // 안전 처리
       lock_release(&file_ref_lock);
       return false;
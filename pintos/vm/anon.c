@@ -7,6 +7,7 @@
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #include "threads/mmu.h"
+#include "threads/malloc.h"
 
 /* DO NOT MODIFY BELOW LINE */
 static bool anon_swap_in (struct page *page, void *kva);
@@ -40,11 +41,15 @@ vm_anon_init (void) {
 	disk_sector_t swap_dsize = disk_size(swap_disk);
 	size_t slot_count = swap_dsize / SECTORS_PER_SLOT;
 
-	swap_table = bitmap_create(slot_count);
-	if (swap_table == NULL) return;
+	// 작은 비트맵은 malloc 블록에 들어가고, 큰 비트맵은 연속된 페이지가 없으면
+	// malloc이 vmalloc으로 받아 온다
+	size_t buf_size = bitmap_buf_size(slot_count);
+	void *buf = malloc_tagged(buf_size, MEM_VM);
+	if (buf == NULL) return;
+	swap_table = bitmap_create_in_buf(slot_count, buf, buf_size);
 
 	bitmap_set_all(swap_table, false);
-	lock_init(&swap_lock);
+	lock_init_named(&swap_lock, "swap");
 }
 
 /* Initialize the file mapping */
@@ -122,8 +127,6 @@ static void anon_destroy(struct page *page) {
 		pml4_clear_page(cur->pml4, page->va);
 		}
 
-		page->frame->page = NULL;
-		vm_free_frame(page->frame);
-		page->frame = NULL;
+		vm_release_frame(page);  // 공유 중이면 참조만 내려놓는다
 	}
 }
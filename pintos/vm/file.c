@@ -4,6 +4,7 @@
 
 #include <string.h>
 
+#include "threads/malloc.h"
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
 #include "userprog/process.h"
@@ -147,7 +148,7 @@ void *do_mmap(void *addr, size_t length, int writable, struct file *file,
 	// 할당해야 하는 페이지 수 만큼 반복
 	for (int i = 0; i < page_count; i++) {
 		// aux 생성
-		struct file_page *aux = malloc(sizeof *aux);
+		struct file_page *aux = malloc_tagged(sizeof *aux, MEM_VM);
 		if (!aux) {
 			do_munmap(upage);
 			return NULL;
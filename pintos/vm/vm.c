@@ -1,7 +1,9 @@
 /* vm.c: Generic interface for virtual memory objects. */
 /* vm.c: 가상 메모리 객체를 위한 일반 인터페이스 */
 
+#include <string.h>
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "vm/vm.h"
 #include "vm/inspect.h"
 #include "threads/mmu.h"
@@ -9,11 +11,15 @@
 #include "vm/file.h"
 #include "vm/uninit.h"
 #include "filesys/file.h"
+#include "intrinsic.h"
 
 #define STACK_MAX_BYTES (1 << 20)  // 스택 성장 한계
+#define CR0_WP (1 << 16)           // 커널 모드 쓰기도 읽기 전용 PTE를 따른다
 
 extern struct lock filesys_lock;
 static struct lock frame_lock;
+static struct kmem_cache *page_cache;   // struct page 전용 슬랩 캐시
+static struct kmem_cache *frame_cache;  // struct frame 전용 슬랩 캐시
 
 #ifdef VM
 /* process.c의 struct load_aux와 동일한 레이아웃 (미러 선언) */
@@ -45,7 +51,7 @@ dup_aux_for_file_uninit(const void *aux0,
                         struct file *child_exec) {
 	if (aux0 == NULL) return NULL;
 	const struct load_aux *src = aux0;
-	struct load_aux *dst = malloc(sizeof *dst);
+	struct load_aux *dst = malloc_tagged(sizeof *dst, MEM_VM);
 	if (!dst) return NULL;
 	*dst = *src;
 	if (src->file == parent_exec) {
@@ -75,8 +81,14 @@ vm_init (void) {
 	/* TODO: Your code goes here. */
 	/* TODO: 여기에 코드를 작성하라. */
 	list_init(&frame_table);
-	lock_init(&frame_lock);
+	lock_init_named(&frame_lock, "frame");
+	page_cache = kmem_cache_create("page", sizeof (struct page), NULL, MEM_VM);
+	frame_cache = kmem_cache_create("frame", sizeof (struct frame), NULL, MEM_VM);
 	start = list_begin(&frame_table);
+
+	/* copy-on-write로 공유한 프레임은 읽기 전용으로 매핑된다.
+	 * 시스템 콜이 사용자 버퍼에 쓸 때도 폴트가 나야 사본을 떼어 줄 수 있다. */
+	lcr0(rcr0() | CR0_WP);
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -100,7 +112,14 @@ page_get_type (struct page *page) {
 /* 헬퍼 함수들 */
 static struct frame *vm_get_victim (void);
 static bool vm_do_claim_page (struct page *page);
+static void vm_promote_huge (struct page *page);
+static bool huge_page_ready (struct page *p, struct page *page);
+static void huge_unpin (uint8_t *base, size_t cnt);
 static struct frame *vm_evict_frame (void);
+static void vm_free_frame (struct frame *frame);
+static void frame_attach (struct frame *frame, struct page *page);
+static void frame_table_remove (struct frame *frame);
+static bool frame_test_and_clear_accessed (struct frame *frame);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -129,7 +148,7 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 		 * TODO: uninit_new 호출 이후에 필드를 수정해야 한다. */
 
 		/* 페이지 객체 생성 */
-		struct page *page = calloc(1, sizeof *page);
+		struct page *page = kmem_cache_zalloc(page_cache);
 		if (page == NULL)
 			goto err;
 
@@ -141,7 +160,7 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 			case VM_ANON: type_init = anon_initializer; break;
 			case VM_FILE: type_init = file_backed_initializer; break;
 			default:
-				free(page);
+				kmem_cache_free(page_cache, page);
 				goto err;
 		}
 
@@ -154,7 +173,7 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 		/* TODO: Insert the page into the spt. */
 		/* TODO: 페이지를 보조 페이지 테이블에 삽입한다. */
 		if (!spt_insert_page(spt, page)) {
-			free(page);
+			kmem_cache_free(page_cache, page);
 			goto err;
 		}
 		return true;
@@ -198,34 +217,47 @@ spt_remove_page (struct supplemental_page_table *spt, struct page *page) {
 }
 
 /* Get the struct frame, that will be evicted. */
-/* 제거(evict)될 프레임을 가져온다. */
+/* 제거(evict)될 프레임을 가져온다. 고를 프레임이 없으면 NULL.
+ * frame_lock을 쥐고 불러야 한다. */
 static struct frame *
 vm_get_victim (void) {
 	struct frame *victim = NULL;
 	 /* TODO: The policy for eviction is up to you. */
 	 /* TODO: 어떤 프레임을 제거할지 결정하는 정책은 직접 구현한다. */
-	struct thread *curr = thread_current();
-	struct list_elem *e = start;
-
-	/*  */
-	for (start = e; start != list_end(&frame_table); start = list_next(start))
-	{
+	size_t i, cnt = list_size(&frame_table);
+
+	/* 시계 바늘을 두 바퀴까지 돌린다. 첫 바퀴에서 접근 비트를 지우므로
+	 * 둘째 바퀴에서는 대개 고를 수 있다.
+	 * 페이지가 아직 붙지 않았거나 축출 중인 프레임은 건너뛴다 */
+	for (i = 0; i < 2 * cnt; i++) {
+		if (start == list_end(&frame_table))
+			start = list_begin(&frame_table);
 		victim = list_entry(start, struct frame, frame_elem);
-		if (pml4_is_accessed(curr->pml4, victim->page->va))
-			pml4_set_accessed(curr->pml4, victim->page->va, 0);
-		else
+		start = list_next(start);
+		if (!list_empty(&victim->pages) && !victim->pinned
+				&& !frame_test_and_clear_accessed(victim))
 			return victim;
 	}
+	return NULL;
+}
 
-	for (start = list_begin(&frame_table); start != e; start = list_next(start))
-	{
-		victim = list_entry(start, struct frame, frame_elem);
-		if (pml4_is_accessed(curr->pml4, victim->page->va))
-			pml4_set_accessed(curr->pml4, victim->page->va, 0);
-		else
-			return victim;
+/* FRAME을 매핑한 페이지 중 하나라도 최근에 접근됐으면 true.
+ * 확인하면서 각 페이지 주인의 접근 비트를 지운다. */
+static bool
+frame_test_and_clear_accessed (struct frame *frame) {
+	bool accessed = false;
+	struct list_elem *e;
+
+	for (e = list_begin(&frame->pages); e != list_end(&frame->pages); e = list_next(e)) {
+		struct page *p = list_entry(e, struct page, share_elem);
+		uint64_t *pml4 = p->owner ? p->owner->pml4 : NULL;
+
+		if (pml4 != NULL && pml4_is_accessed(pml4, p->va)) {
+			pml4_set_accessed(pml4, p->va, 0);
+			accessed = true;
+		}
 	}
-	return victim;
+	return accessed;
 }
 
 /* Evict one page and return the corresponding frame.
@@ -234,25 +266,48 @@ vm_get_victim (void) {
  * 오류 시 NULL을 반환한다. */
 static struct frame *
 vm_evict_frame (void) {
-	struct frame *victim UNUSED = vm_get_victim();
+	struct frame *victim;
+	bool ok = true;
+
+	/* 축출하는 동안 프레임을 고정한다. 다른 축출은 이 프레임을 건너뛰고,
+	 * 덤으로 얹은 참조 덕분에 공유하던 쪽이 끝나거나 사본을 받아 떠나도
+	 * vm_release_frame이 프레임을 풀지 않는다 */
+	lock_acquire(&frame_lock);
+	victim = vm_get_victim();
 	/* TODO: swap out the victim and return the evicted frame. */
-	if (victim == NULL) return NULL;
-	struct page *page = victim->page;
-	ASSERT(page != NULL);
-
-	if (!swap_out(page)) {
-		list_push_back(&frame_table, &victim->frame_elem);
+	if (victim == NULL) {
+		lock_release(&frame_lock);
 		return NULL;
 	}
+	victim->pinned = true;
+	victim->ref_cnt++;
+
+	/* 공유 중인 프레임이면 붙은 페이지마다 내보낸다.
+	 * 익명 페이지는 각자 스왑 슬롯을 받으므로 다시 올라올 때는 따로 올라온다.
+	 * swap_out이 잠든 사이 페이지가 떨어져 나갈 수 있으니 매번 맨 앞부터 다시 본다.
+	 * 매핑 제거는 여기서 일관되게 처리: dirty 판단 후 바로 매핑 끊기.
+	 * huge page에 속한 페이지면 pml4_clear_page가 먼저 4 KiB 페이지들로 쪼갠다 */
+	while (ok && !list_empty(&victim->pages)) {
+		struct page *page = list_entry(list_front(&victim->pages),
+		                               struct page, share_elem);
+		lock_release(&frame_lock);
+		ok = swap_out(page);
+		lock_acquire(&frame_lock);
+		if (!ok || page->frame != victim)
+			continue;
+		list_remove(&page->share_elem);
+		victim->ref_cnt--;
+		if (page->owner && page->owner->pml4)
+			pml4_clear_page(page->owner->pml4, page->va);
+		page->frame = NULL;
+	}
 
-	/* 매핑 제거는 여기서 일관되게 처리
-	* dirty 판단 후 바로 매핑 끊기
-	*/
-	if (page->owner && page->owner->pml4)
-		pml4_clear_page(page->owner->pml4, page->va);
-
-	page->frame = NULL;
-	victim->page = NULL;
+	/* 고정을 푼다. 내보내다 실패해도 그 사이 페이지가 모두 떠났으면 빈 프레임이다 */
+	victim->pinned = false;
+	victim->ref_cnt--;
+	if (!list_empty(&victim->pages))
+		victim = NULL;
+	lock_release(&frame_lock);
 	return victim;
 }
 
@@ -266,23 +321,29 @@ vm_evict_frame (void) {
  * 즉, 사용자 풀 메모리가 가득 찼을 경우 이 함수는 프레임을 제거해 가용 메모리를 확보한다. */
 static struct frame *
 vm_get_frame (void) {
-	struct frame *frame = (struct frame *)malloc(sizeof(struct frame));
-	void *kva = palloc_get_page(PAL_USER);
+	struct frame *frame;
+	void *kva = palloc_get_page(PAL_USER | PAL_TAG(MEM_VM));
 
-	// oom시 아직은 패닉으로 처리 나중에 evict로 대체
+	// 빈 페이지가 없으면 기존 프레임을 재사용하므로 새 frame을 만들지 않는다
 	if (kva == NULL) {
 		frame = vm_evict_frame();
-		frame->page = NULL;
+		if (frame == NULL)
+			PANIC("vm_get_frame: no frame to evict");
 
 		return frame;
 	}
 
-	list_push_back (&frame_table, &frame->frame_elem);  
-
-	ASSERT (frame != NULL);
+	frame = kmem_cache_alloc(frame_cache);
+	if (frame == NULL)
+		PANIC("vm_get_frame: out of memory");
 	frame->kva = kva;
-	frame->page = NULL;
-	// 나중에 프레임에 추가 기능
+	list_init(&frame->pages);
+	frame->ref_cnt = 0;
+	frame->pinned = false;
+
+	lock_acquire(&frame_lock);
+	list_push_back (&frame_table, &frame->frame_elem);
+	lock_release(&frame_lock);
 	return frame;
 }
 
@@ -293,9 +354,52 @@ vm_stack_growth (void *addr UNUSED) {
 }
 
 /* Handle the fault on write_protected page */
-/* 쓰기 보호된 페이지에서 발생한 페이지 폴트를 처리한다. */
-static bool
-vm_handle_wp (struct page *page UNUSED) {
+/* 쓰기 보호된 페이지에서 발생한 페이지 폴트를 처리한다.
+ * fork가 공유시킨 프레임이면 새 프레임에 복사해 떼어 내고,
+ * 이미 혼자 남은 프레임이면 쓰기만 다시 허용한다.
+ * 커널 별칭으로 사용자 페이지에 쓰려는 시스템 콜도 먼저 이걸 불러야 한다.
+ * 옛 프레임이 축출됐으면 매핑 없이 true를 돌려주니 호출자가 다시 확인한다. */
+bool
+vm_handle_wp (struct page *page) {
+	struct thread *cur = thread_current();
+	struct frame *old = page->frame;
+	struct frame *new;
+	bool shared, dirty;
+
+	if (old == NULL)
+		return false;
+
+	/* ref_cnt에는 축출 중 고정하느라 얹은 참조가 섞일 수 있으니 페이지 수를 센다 */
+	lock_acquire(&frame_lock);
+	shared = list_size(&old->pages) > 1;
+	lock_release(&frame_lock);
+	if (!shared)
+		return pml4_set_writable(cur->pml4, page->va, true);
+
+	new = vm_get_frame();
+
+	/* 프레임을 구하는 사이 옛 프레임이 축출됐으면 매핑도 없어졌다.
+	 * 새 프레임은 돌려주고, 다시 접근할 때 나는 not-present 폴트에 맡긴다 */
+	if (page->frame != old) {
+		lock_acquire(&frame_lock);
+		frame_table_remove(new);
+		lock_release(&frame_lock);
+		vm_free_frame(new);
+		return true;
+	}
+
+	memcpy(new->kva, old->kva, PGSIZE);
+	dirty = pml4_is_dirty(cur->pml4, page->va);
+	pml4_clear_page(cur->pml4, page->va);
+	vm_release_frame(page);
+	frame_attach(new, page);
+	if (!pml4_set_page(cur->pml4, page->va, new->kva, true)) {
+		vm_release_frame(page);
+		return false;
+	}
+	if (dirty)
+		pml4_set_dirty(cur->pml4, page->va, true);
+	return true;
 }
 
 /* Return true on success */
@@ -303,19 +407,27 @@ vm_handle_wp (struct page *page UNUSED) {
 bool
 vm_try_handle_fault (struct intr_frame *f, void *addr,
 		bool user, bool write, bool not_present) {
-	if (!not_present) return false;
 	if (!is_user_vaddr(addr) || addr == NULL) return false;
 
 	/* TODO: Validate the fault */
 	/* TODO: 페이지 폴트를 검증한다. */
 	void *uva = pg_round_down(addr);
 	struct page *page = spt_find_page(&thread_current()->spt, uva);
+
+	/* 올라와 있는 페이지에 쓰다 난 폴트는 copy-on-write뿐이다 */
+	if (!not_present)
+		return write && page != NULL && page->writable && vm_handle_wp(page);
+
 	if (page != NULL) {
 		/* 쓰기 의도인데 read-only면 실패 */
 		if (write && !page->writable)
 		return false;
 		/* 실제 프레임을 확보하고 매핑 */
-		return vm_do_claim_page(page);
+		if (!vm_do_claim_page(page))
+			return false;
+		/* 이걸로 2 MiB 영역이 다 찼으면 huge page 하나로 합친다 */
+		vm_promote_huge(page);
+		return true;
 	}
 
 	/* TODO: Your code goes here */
@@ -369,21 +481,11 @@ vm_dealloc_page (struct page *page) {
 	/* 매핑이 살아있으면 먼저 끊기 */
 	if (owner && owner->pml4) pml4_clear_page(owner->pml4, page->va);
 
-	/* 프레임 보유 중이면 프레임 테이블에서 빼고 반환 */
-	if (page->frame) {
-		struct frame *f = page->frame;
-		page->frame = NULL;
-		if (f->page == page) f->page = NULL;
-
-		lock_acquire(&frame_lock);
-		list_remove(&f->frame_elem);
-		lock_release(&frame_lock);
-
-		vm_free_frame(f);  // palloc_free_page + free
-	}
+	/* 프레임 보유 중이면 떼어 내고, 마지막 참조였으면 프레임도 반환 */
+	vm_release_frame(page);
 
 	destroy(page);
-	free(page);
+	kmem_cache_free(page_cache, page);
 }
 
 /* Claim the page that allocate on VA. */
@@ -399,11 +501,53 @@ vm_claim_page (void *va UNUSED) {
 	return vm_do_claim_page (page);
 }
 
-void vm_free_frame(struct frame *frame) {
+static void vm_free_frame(struct frame *frame) {
 	ASSERT(frame != NULL);
-	ASSERT(frame->page == NULL);
+	ASSERT(list_empty(&frame->pages));
 	palloc_free_page(frame->kva);
-	free(frame);
+	kmem_cache_free(frame_cache, frame);
+}
+
+/* PAGE를 FRAME에 붙인다. */
+static void
+frame_attach (struct frame *frame, struct page *page) {
+	lock_acquire(&frame_lock);
+	list_push_back(&frame->pages, &page->share_elem);
+	frame->ref_cnt++;
+	page->frame = frame;
+	lock_release(&frame_lock);
+}
+
+/* FRAME을 프레임 테이블에서 뺀다. 시계 바늘이 FRAME을 가리키고 있으면
+ * 다음 프레임으로 옮긴다. frame_lock을 쥐고 불러야 한다. */
+static void
+frame_table_remove (struct frame *frame) {
+	if (start == &frame->frame_elem)
+		start = list_remove(&frame->frame_elem);
+	else
+		list_remove(&frame->frame_elem);
+}
+
+/* PAGE를 프레임에서 떼어 낸다. 마지막으로 붙어 있던 페이지였으면
+ * 프레임을 프레임 테이블에서 빼고 돌려준다. 매핑은 호출자가 끊는다. */
+void
+vm_release_frame (struct page *page) {
+	struct frame *frame = page->frame;
+	bool last;
+
+	if (frame == NULL)
+		return;
+
+	lock_acquire(&frame_lock);
+	list_remove(&page->share_elem);
+	page->frame = NULL;
+	last = --frame->ref_cnt == 0;
+	if (last)
+		frame_table_remove(frame);
+	lock_release(&frame_lock);
+
+	if (last)
+		vm_free_frame(frame);
 }
 
 /* Claim the PAGE and set up the mmu. */
@@ -414,28 +558,112 @@ vm_do_claim_page (struct page *page) {
 
 	/* Set links */
 	/* 페이지와 프레임을 연결한다. */
-	frame->page = page;
-	page->frame = frame;
+	frame_attach(frame, page);
 
 	/* TODO: Insert page table entry to map page's VA to frame's PA. */
 	/* TODO: 페이지의 VA를 프레임의 PA에 매핑하는 페이지 테이블 엔트리를 삽입한다. */
-	struct thread *cur = thread_current();
+	/* fork 중에는 자식이 부모의 페이지를 올리므로 현재 스레드가 아닌 주인의 테이블에 매핑한다 */
+	struct thread *owner = page->owner;
 	if (!swap_in(page, frame->kva)) {
-		frame->page = NULL;
-		page->frame = NULL;
-		vm_free_frame(frame);
+		vm_release_frame(page);
 		return false;
 	}
 
-	if (!pml4_set_page(cur->pml4, page->va, frame->kva, page->writable)) {
-		frame->page = NULL;
-		page->frame = NULL;
-		vm_free_frame(frame);
+	if (!pml4_set_page(owner->pml4, page->va, frame->kva, page->writable)) {
+		vm_release_frame(page);
 		return false;
 	}
 	return true;
 }
 
+/* PAGE가 속한 2 MiB 정렬 영역의 페이지가 모두 올라와 있으면 huge page 하나로 합친다.
+ * 영역의 모든 페이지가 PAGE와 쓰기 권한이 같은 익명 페이지로 올라와 있고 공유 중이거나
+ * 축출 중이지 않아야 하며, 물리적으로 연속·정렬된 2 MiB가 남아 있어야 한다.
+ * 각 페이지의 내용을 새 자리로 복사하고 원래 4 KiB 프레임은 돌려준다.
+ * 페이지마다 struct frame은 그대로 두고 프레임만 2 MiB 블록의 한 칸을 가리키므로,
+ * 축출할 때는 pml4_clear_page가 매핑을 쪼개는 것으로 충분하다.
+ * 합치지 못해도 PAGE는 이미 4 KiB로 올라와 있으니 호출자는 결과를 볼 필요가 없다. */
+static void
+vm_promote_huge (struct page *page) {
+	struct thread *cur = thread_current();
+	uint8_t *base = hpg_round_down(page->va);
+	size_t idx = ((uint8_t *) page->va - base) / PGSIZE;
+	uint8_t *kva;
+	size_t i;
+
+	if (page_get_type(page) != VM_ANON || base == NULL
+			|| !is_user_vaddr(base + HPGSIZE - 1))
+		return;
+
+	/* 영역을 앞에서부터 채우든 뒤에서부터 채우든 바로 옆 페이지는 대개 아직 비어 있다.
+	 * 양옆과 남은 2 MiB 블록부터 보고, 가망이 있을 때만 영역 전체를 훑는다 */
+	if ((idx > 0 && !huge_page_ready(spt_find_page(&cur->spt, base + (idx - 1) * PGSIZE), page))
+			|| (idx + 1 < HPG_PAGES
+				&& !huge_page_ready(spt_find_page(&cur->spt, base + (idx + 1) * PGSIZE), page))
+			|| !palloc_huge_available(PAL_USER))
+		return;
+
+	/* 옮기는 동안 축출되지 않게 프레임을 고정한다 */
+	lock_acquire(&frame_lock);
+	for (i = 0; i < HPG_PAGES; i++) {
+		struct page *p = spt_find_page(&cur->spt, base + i * PGSIZE);
+		if (!huge_page_ready(p, page))
+			break;
+		p->frame->pinned = true;
+	}
+	lock_release(&frame_lock);
+	if (i < HPG_PAGES) {
+		huge_unpin(base, i);
+		return;
+	}
+
+	kva = palloc_get_huge_page(PAL_USER | PAL_TAG(MEM_VM));
+	if (kva == NULL) {
+		huge_unpin(base, HPG_PAGES);
+		return;
+	}
+
+	/* 내용을 옮긴 뒤 매핑을 바꾼다. 매핑이 바뀌기 전까지는 옛 프레임이 그대로 쓰인다 */
+	for (i = 0; i < HPG_PAGES; i++)
+		memcpy(kva + i * PGSIZE,
+		       spt_find_page(&cur->spt, base + i * PGSIZE)->frame->kva, PGSIZE);
+	if (!pml4_set_huge_page(cur->pml4, base, kva, page->writable)) {
+		for (i = 0; i < HPG_PAGES; i++)   // 각 칸은 따로 해제할 수 있는 페이지다
+			palloc_free_page(kva + i * PGSIZE);
+		huge_unpin(base, HPG_PAGES);
+		return;
+	}
+	for (i = 0; i < HPG_PAGES; i++) {
+		struct frame *f = spt_find_page(&cur->spt, base + i * PGSIZE)->frame;
+
+		palloc_free_page(f->kva);
+		f->kva = kva + i * PGSIZE;
+	}
+	huge_unpin(base, HPG_PAGES);
+}
+
+/* P가 PAGE와 함께 huge page로 합쳐질 수 있으면 true.
+ * 쓰기 권한이 같은 익명 페이지로 혼자 쓰는 프레임에 올라와 있어야 한다.
+ * frame_lock 없이 부르면 참고용 답일 뿐이다. */
+static bool
+huge_page_ready (struct page *p, struct page *page) {
+	return p != NULL && page_get_type(p) == VM_ANON
+		&& p->writable == page->writable
+		&& p->frame != NULL && p->frame->ref_cnt == 1 && !p->frame->pinned;
+}
+
+/* BASE부터 CNT개 페이지의 프레임 고정을 푼다. */
+static void
+huge_unpin (uint8_t *base, size_t cnt) {
+	struct thread *cur = thread_current();
+	size_t i;
+
+	lock_acquire(&frame_lock);
+	for (i = 0; i < cnt; i++)
+		spt_find_page(&cur->spt, base + i * PGSIZE)->frame->pinned = false;
+	lock_release(&frame_lock);
+}
+
 /* Initialize new supplemental page table */
 /* 새로운 보조 페이지 테이블을 초기화한다. */
 void
@@ -492,19 +720,24 @@ supplemental_page_table_copy (struct supplemental_page_table *dst,
 		continue;
     }
 
-    /* 이미 메모리에 올라온 페이지(ANON 또는 FILE) → 자식에 ANON 생성 후 내용 복사 */
+    /* 초기화된 페이지(ANON 또는 FILE) → 자식에 ANON 생성 후 프레임 공유.
+     * 양쪽 다 읽기 전용으로 매핑하고, 먼저 쓰는 쪽이 vm_handle_wp에서 사본을 받는다 */
     if (!vm_alloc_page_with_initializer(VM_ANON, va, writable, NULL, NULL))
 		goto fail;
-	if (!vm_claim_page(va))
-		goto fail;
 
     struct page *dp = spt_find_page(dst, va);
-    if (dp == NULL || dp->frame == NULL) goto fail;
+    if (dp == NULL) goto fail;
 
-    /* 부모 페이지는 이미 메모리에 있어야 함 (swap 미구현 가정) */
-    if (sp->frame == NULL) goto fail;
+    /* 축출된 부모 페이지는 부모 쪽에 다시 올린 뒤 공유한다 */
+    if (sp->frame == NULL && !vm_do_claim_page(sp))
+		goto fail;
 
-    memcpy(dp->frame->kva, sp->frame->kva, PGSIZE);
+    anon_initializer(dp, VM_ANON, NULL);
+    frame_attach(sp->frame, dp);
+    if (!pml4_set_page(thread_current()->pml4, va, sp->frame->kva, false))
+		goto fail;
+    if (!pml4_set_writable(sp->owner->pml4, va, false))
+		goto fail;
   }
 
   return true;
@@ -520,7 +753,8 @@ fail:
 static void page_free_action(struct hash_elem *e, void *aux) {
   struct page *p = hash_entry(e, struct page, spt_elem);
   destroy(p);
-  free(p);
+  vm_release_frame(p);  // 프레임을 놓지 않는 destroy(파일 페이지 등)의 뒷정리
+  kmem_cache_free(page_cache, p);
 }
 
 /* Free the resource hold by the supplemental page table */